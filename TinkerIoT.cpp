@@ -1,9 +1,11 @@
 #include "TinkerIoT.h"
 
-// Global instances
-TinkerIoTClass TinkerIoT;
+// Global instances (the client is in TinkerIoTGlobal.cpp)
 TinkerIoTParam param;
 
+// The settings this file was built with (see BUILD CHECK)
+const char tinkerIoTBuild[] = TINKERIOT_BUILD_TAG;
+
 // Static instance pointer for callback
 TinkerIoTClass* TinkerIoTClass::instance = nullptr;
 
@@ -12,7 +14,7 @@ TinkerIoTClass* TinkerIoTClass::instance = nullptr;
 // Initialize static member
 TinkerIoTAutoRegister::HandlerNode* TinkerIoTAutoRegister::handlerList = nullptr;
 
-void TinkerIoTAutoRegister::registerAll() {
+void TinkerIoTAutoRegister::registerAll(TinkerIoTClass& client) {
     HandlerNode* current = handlerList;
     int registeredCount = 0;
     
@@ -23,8 +25,8 @@ void TinkerIoTAutoRegister::registerAll() {
     #endif
     
     while (current != nullptr) {
-        if (current->handler != nullptr) {
-            TinkerIoT._registerWriteHandler(current->pin, current->handler);
+        if (current->handler.kind != TinkerIoTHandler::NONE) {
+            client._registerWriteHandler(current->pin, current->handler);
             registeredCount++;
             
             #ifdef TINKERIOT_PRINT
@@ -53,7 +55,7 @@ int TinkerIoTAutoRegister::getHandlerCount() {
     HandlerNode* current = handlerList;
     
     while (current != nullptr) {
-        if (current->handler != nullptr) {
+        if (current->handler.kind != TinkerIoTHandler::NONE) {
             count++;
         }
         current = current->next;
@@ -63,12 +65,27 @@ int TinkerIoTAutoRegister::getHandlerCount() {
 }
 
 // Constructor - Enhanced with auto-registration info
-TinkerIoTClass::TinkerIoTClass() {
+// The tables arrive zeroed: version 0, TINKERIOT_VALUE_EMPTY, no policy
+TinkerIoTClass::TinkerIoTClass(const TinkerIoTTables& tables)
+    : pinCount(tables.pins),
+      valueLength(tables.valueLength),
+      slotWords(tables.slotWords),
+      cloudPins(tables.slots),
+      pinReports(tables.reports),
+      writeHandlers(tables.handlers),
+      handlerTimings(tables.timings),
+      inFlight(tables.inFlight),
+      ackCapacity(tables.ackWindow),
+      netQueues(tables.netQueues),
+      netQueueSlots(tables.netQueueSlots),
+      netFrameSize(tables.netFrameSize),
+      txFrame(tables.txBuffer, tables.txBufferSize),
+      dirtyPins(tables.dirty),
+      echoPins(tables.echoes) {
     instance = this;
-    // Initialize cloud pins
-    for (int i = 0; i < 32; i++) {
-        cloudPins[i] = "";
-        writeHandlers[i] = nullptr;
+    for (uint16_t pin = 0; pin < pinCount; pin++) {
+        pinReports[pin].decimals = TINKERIOT_FLOAT_DECIMALS;
+        pinReports[pin].echo = TINKERIOT_ECHO_POLICY;
     }
     // Initialize token validation variables
     tokenErrorReported = false;
@@ -109,8 +126,8 @@ void TinkerIoTClass::begin(const char* auth_token, const char* ssid, const char*
     TINKERIOT_PRINT.println(auth_token);    TINKERIOT_PRINT.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
     #endif
     
+    // Start associating; run() takes it from here (see TinkerIoTState)
     connectToWiFi();
-    setupWebSocket();
     
     // ===== AUTOMATIC HANDLER REGISTRATION =====
     #ifdef TINKERIOT_PRINT
@@ -121,131 +138,1753 @@ void TinkerIoTClass::begin(const char* auth_token, const char* ssid, const char*
     TINKERIOT_PRINT.println(" TINKERIOT_WRITE handlers for auto-registration");    }
     #endif
     
-    TinkerIoTAutoRegister::registerAll();
+    instance = this;  // WebSocket events go to the client that began last
+    TinkerIoTAutoRegister::registerAll(*this);
 }
 
 // Main run function (call this in loop)
 void TinkerIoTClass::run() {
-    // 🚀 PRIORITY FIX: Process incoming messages AGGRESSIVELY
-    // This ensures button commands are received instantly even during timer floods
-    // Call webSocket.loop() 10 times to drain incoming message queue
-    for (int i = 0; i < 10; i++) {
+    // A batch never spans run(): inbound replies reuse the transmit buffer
+    commitBatch();
+
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    if (networkTaskActive) {
+        // The network task owns the socket: run the commands it queued
+        receiveQueued();
+    } else
+    #endif
+    {
+        // 🚀 PRIORITY FIX: Process incoming messages AGGRESSIVELY
+        // This ensures button commands are received instantly even during timer floods
+        if (webSocketStarted) {
+            drainSocket();
+        }
+
+        // WiFi -> WebSocket -> login, one non-blocking step per call
+        runConnection();
+    }
+    
+    // Coalescing mode: send the latest value of every dirty pin
+    if (coalesceWrites && millis() - lastFlush >= coalesceInterval) {
+        lastFlush = millis();
+        flush();
+    }
+    
+    // Acknowledged sends: give up on overdue frames, then send what the
+    // window or the QUOTA_LIMIT pacing held back
+    if (inFlightCount > 0 && (linkState() != TINKERIOT_READY || (long)(millis() - ackDue()) >= 0)) {
+        expireAcks();
+    }
+    if (deferredPins && linkState() == TINKERIOT_READY && sendWindowOpen()) {
+        flush();
+    }
+
+    // Coalesced echoes: one frame for every pin marked since the last one
+    if (echoPending && linkState() == TINKERIOT_READY && sendWindowOpen() && (long)(millis() - echoDue()) >= 0) {
+        flushEchoes();
+    }
+
+    // Store and forward: next paced frame of the offline backlog
+    if (linkState() == TINKERIOT_READY && offlineQueue.enabled() && offlineQueue.depth() > 0 &&
+        (long)(millis() - replayDue()) >= 0 && sendWindowOpen()) {
+        replayOffline();
+    }
+
+    // Reporting policies: resend pins that have been silent too long
+    if (silenceWatch && (long)(millis() - silenceDue) >= 0) {
+        sendSilentPins();
+    }
+    
+    // Latency probe: PING the server, the answer's delay goes to the RTT histogram
+    if (probeInterval && linkState() == TINKERIOT_READY && millis() - lastProbe >= probeInterval) {
+        lastProbe = millis();
+        sendProbe();
+    }
+    if (latencyPin >= 0 && latencyInterval && linkState() == TINKERIOT_READY &&
+        millis() - lastLatencyReport >= latencyInterval) {
+        lastLatencyReport = millis();
+        publishLatency();
+    }
+
+    // Deferred log: format a few records, only when no input is waiting
+    #if TINKERIOT_LOG_LEVEL > 0
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    bool inputLeft = networkTaskActive ? !inboundRing.empty() : drainBudgetHit;  // The latter is the network task's
+    #else
+    bool inputLeft = drainBudgetHit;
+    #endif
+    if (logOutput && !inputLeft) {
+        writeLog(*logOutput, TINKERIOT_LOG_DRAIN_PER_RUN, true);
+    }
+    #endif
+}
+
+// ===== INBOUND DRAIN =====
+
+// Call webSocket.loop() while it keeps producing events (it handles at most
+// one frame per call), within the frame and time budgets
+void TinkerIoTClass::drainSocket() {
+    unsigned long start = micros();
+    uint16_t frames = 0;
+    drainBudgetHit = false;
+
+    for (;;) {
+        #ifdef TINKERIOT_HAS_NETWORK_TASK
+        // Leave input in the socket until the application catches up
+        if (networkTaskActive && inboundRing.full()) break;
+        #endif
+
+        uint32_t before = socketEvents;
         webSocket.loop();
         yield();  // Let ESP32 process WiFi/system tasks
+        if (socketEvents == before) break;  // Nothing more waiting
+
+        frames++;
+        if ((drainMaxFrames && frames >= drainMaxFrames) ||
+            (drainMaxMicros && micros() - start >= drainMaxMicros)) {
+            drainBudgetHit = true;
+            drainStats.budgetHits++;
+            break;
+        }
+    }
+
+    unsigned long spent = micros() - start;
+    drainStats.runs++;
+    drainStats.frames += frames;
+    drainStats.lastFrames = frames;
+    drainStats.lastMicros = spent;
+    if (frames > drainStats.maxFrames) drainStats.maxFrames = frames;
+    if (spent > drainStats.maxMicros) drainStats.maxMicros = spent;
+}
+
+void TinkerIoTClass::setDrainBudget(uint16_t maxFrames, unsigned long maxMicros) {
+    drainMaxFrames = maxFrames;
+    drainMaxMicros = maxMicros;
+}
+
+void TinkerIoTClass::resetDrainStats() {
+    memset(&drainStats, 0, sizeof(drainStats));
+}
+
+// ===== IDLE WAITING =====
+
+// Time left until 'deadline' (0 if it passed), folded into 'next'
+static void earliest(unsigned long& next, unsigned long now, unsigned long deadline) {
+    long left = (long)(deadline - now);
+    unsigned long ms = left > 0 ? (unsigned long)left : 0;
+    if (ms < next) next = ms;
+}
+
+unsigned long TinkerIoTClass::msUntilNext() {
+    unsigned long now = millis();
+    unsigned long next = TINKERIOT_NO_DEADLINE;
+
+    // With a network task, it waits on the connection and the
+    // application task waits on queued commands and the pin deadlines
+    bool ownsSocket = true;
+    bool ownsPins = true;
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    if (networkTaskActive) {
+        ownsSocket = onNetworkTask();
+        ownsPins = !ownsSocket;
+        if (ownsSocket && !outboundRing.empty()) return 0;
+        if (ownsPins && !inboundRing.empty()) return 0;
+    }
+    #endif
+
+    if (ownsSocket) {
+        // The last drain stopped on its budget: more input is probably waiting
+        if (drainBudgetHit) return 0;
+
+        switch (linkState()) {
+            case TINKERIOT_IDLE:
+                return next;
+            case TINKERIOT_WIFI_CONNECTING:
+            case TINKERIOT_WS_CONNECTING:
+                earliest(next, now, now + 100);  // Poll the association / reconnect
+                break;
+            case TINKERIOT_LOGGING_IN:
+                if (loginPending) {
+                    earliest(next, now, loginTime() + loginTimeout + 1);
+                } else if (!loginFailed) {
+                    earliest(next, now, phaseStart + loginDelay);
+                }
+                break;
+            default:
+                break;
+        }
+
+        if (linkState() > TINKERIOT_WIFI_CONNECTING) {
+            earliest(next, now, lastWiFiCheck + 500);
+        }
+    }
+    if (ownsPins) {
+        if (coalesceWrites && hasDirtyPins()) {
+            earliest(next, now, lastFlush + coalesceInterval);
+        }
+        if (silenceWatch) {
+            earliest(next, now, silenceDue);
+        }
+        if (linkState() == TINKERIOT_READY && offlineQueue.enabled() && offlineQueue.depth() > 0) {
+            earliest(next, now, replayDue());
+        }
+        if (inFlightCount > 0) {
+            earliest(next, now, ackDue());
+        }
+        if (echoPending && linkState() == TINKERIOT_READY) {
+            if (sendWindowOpen()) {
+                earliest(next, now, echoDue());
+            } else if (sendInterval > 0) {
+                earliest(next, now, lastFrameSent + sendInterval);  // A full window waits for a RESPONSE instead
+            }
+        }
+        if (probeInterval && linkState() == TINKERIOT_READY) {
+            earliest(next, now, lastProbe + probeInterval);
+        }
+        if (latencyPin >= 0 && latencyInterval && linkState() == TINKERIOT_READY) {
+            earliest(next, now, lastLatencyReport + latencyInterval);
+        }
+        #if TINKERIOT_LOG_LEVEL > 0
+        if (logOutput && logTail != __atomic_load_n(&logHead, __ATOMIC_RELAXED)) {
+            earliest(next, now, logStalled ? now + 1 : now);  // Records to print, once the output drains
+        }
+        #endif
+        if (deferredPins && sendInterval > 0) {
+            earliest(next, now, lastFrameSent + sendInterval);  // A full window waits for a RESPONSE instead
+        }
+    }
+    return next;
+}
+
+void TinkerIoTClass::waitForEvent(unsigned long maxWaitMs) {
+    unsigned long wait = msUntilNext();
+    if (maxWaitMs < wait) wait = maxWaitMs;
+    if (wait == 0) return;
+
+    #if defined(TINKERIOT_HOST)
+    if (networkTaskActive) {
+        // Queued commands arrive through notify()
+        std::unique_lock<std::mutex> lock(wakeLock);
+        if (wait == TINKERIOT_NO_DEADLINE) {
+            wakeCond.wait(lock, [this] { return wakePending; });
+        } else {
+            wakeCond.wait_for(lock, std::chrono::milliseconds(wait), [this] { return wakePending; });
+        }
+        wakePending = false;
+        return;
+    }
+    // The host transport exposes its socket: poll() it and the wake pipe
+    TinkerIoTHost::linkWait(wait);
+    #elif defined(ESP32)
+    // Sleep on a task notification; notify() ends it early
+    waitTask = xTaskGetCurrentTaskHandle();
+    if (networkTaskActive) {
+        // Queued commands arrive with a notification: no need to poll
+        ulTaskNotifyTake(pdTRUE, wait == TINKERIOT_NO_DEADLINE ? portMAX_DELAY : pdMS_TO_TICKS(wait));
+        return;
+    }
+    if (wait > TINKERIOT_WAIT_SLICE_MS) wait = TINKERIOT_WAIT_SLICE_MS;
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    #else
+    // delay() lets the ESP8266 modem sleep; check for notify() every ms
+    if (wait > TINKERIOT_WAIT_SLICE_MS) wait = TINKERIOT_WAIT_SLICE_MS;
+    unsigned long start = millis();
+    while (!wakeRequested && millis() - start < wait) {
+        delay(1);
+    }
+    wakeRequested = false;
+    #endif
+}
+
+void TinkerIoTClass::runUntilIdle(TinkerIoTTimer* timer) {
+    run();
+    if (timer) {
+        timer->run();
+    }
+    waitForEvent(timer ? timer->msUntilNext() : TINKERIOT_NO_DEADLINE);
+}
+
+void TinkerIoTClass::notify() {
+    #if defined(TINKERIOT_HOST)
+    if (networkTaskActive) {
+        {
+            std::lock_guard<std::mutex> guard(wakeLock);
+            wakePending = true;
+        }
+        wakeCond.notify_one();
+        return;
+    }
+    TinkerIoTHost::linkWake();
+    #elif defined(ESP32)
+    TaskHandle_t task = waitTask;
+    if (!task) return;
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        if (woken) portYIELD_FROM_ISR();
+    } else {
+        xTaskNotifyGive(task);
+    }
+    #else
+    wakeRequested = true;
+    #endif
+}
+
+// ===== NETWORK TASK =====
+
+#ifdef TINKERIOT_HAS_NETWORK_TASK
+#if defined(TINKERIOT_HOST)
+static thread_local bool onNetworkThread = false;
+#endif
+
+bool TinkerIoTClass::onNetworkTask() {
+    #if defined(ESP32)
+    return xTaskGetCurrentTaskHandle() == networkTask;
+    #else
+    return onNetworkThread;
+    #endif
+}
+
+bool TinkerIoTClass::startNetworkTask(int core) {
+    if (networkTaskActive) return true;
+    if (!netQueues) return false;  // TinkerIoTClient<..., NetQueueSlots = 0>
+    inboundRing.init(netQueues, netQueueSlots, netFrameSize);
+    outboundRing.init(netQueues + tinkerIoTRingBytes(netQueueSlots, netFrameSize), netQueueSlots, netFrameSize);
+    commitBatch();
+    networkStop = false;
+    networkTaskActive = true;
+
+    #if defined(ESP32)
+    waitTask = xTaskGetCurrentTaskHandle();  // The application task
+    if (xTaskCreatePinnedToCore(networkTaskEntry, "tinkeriot-net", TINKERIOT_NET_TASK_STACK, this,
+                                TINKERIOT_NET_TASK_PRIORITY, (TaskHandle_t*)&networkTask, core) != pdPASS) {
+        networkTaskActive = false;
+        return false;
+    }
+    #else
+    (void)core;
+    networkThread = new std::thread([this] {
+        onNetworkThread = true;
+        networkLoop();
+    });
+    #endif
+
+    #ifdef TINKERIOT_PRINT
+    TINKERIOT_PRINT.print("🧵 Network task started on core ");
+    TINKERIOT_PRINT.println(core);
+    #endif
+    return true;
+}
+
+void TinkerIoTClass::stopNetworkTask() {
+    if (!networkTaskActive) return;
+    __atomic_store_n(&networkStop, true, __ATOMIC_RELEASE);
+    wakeNetworkTask();
+
+    #if defined(ESP32)
+    while (networkTask) {
+        delay(1);
+    }
+    #else
+    networkThread->join();
+    delete networkThread;
+    networkThread = nullptr;
+    #endif
+
+    // The socket is ours again: finish what is still queued
+    networkTaskActive = false;
+    sendQueued();
+    receiveQueued();
+}
+
+#if defined(ESP32)
+void TinkerIoTClass::networkTaskEntry(void* arg) {
+    TinkerIoTClass* self = (TinkerIoTClass*)arg;
+    self->networkLoop();
+    self->networkTask = nullptr;
+    vTaskDelete(NULL);
+}
+#endif
+
+// Everything that touches webSocket: connection, login, PING replies and
+// the frames queued by the application task
+void TinkerIoTClass::networkLoop() {
+    while (!__atomic_load_n(&networkStop, __ATOMIC_ACQUIRE)) {
+        sendQueued();
+        if (webSocketStarted) {
+            drainSocket();
+        }
+        runConnection();
+        sendQueued();
+
+        #if defined(ESP32)
+        // No socket to block on: poll every tick, or sooner on a notification
+        ulTaskNotifyTake(pdTRUE, 1);
+        #else
+        if (inboundRing.full()) {
+            // The socket stays readable until the application catches up
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        unsigned long wait = msUntilNext();
+        if (wait > 100) wait = 100;
+        if (wait) TinkerIoTHost::linkWait(wait);
+        #endif
+    }
+}
+
+// Network task: send the frames the application task queued
+void TinkerIoTClass::sendQueued() {
+    size_t length;
+    uint8_t* frame;
+    while ((frame = outboundRing.front(length)) != nullptr) {
+        countFrame(counters.out, frame, length);
+        webSocket.sendBIN(frame, length);
+        outboundRing.pop();
+    }
+}
+
+// Application task: handle the commands the network task queued
+void TinkerIoTClass::receiveQueued() {
+    uint16_t frames = 0;
+    size_t length;
+    uint8_t* frame;
+    uint32_t arrived;
+    while ((frame = inboundRing.front(length, &arrived)) != nullptr) {
+        rxMicros = arrived;
+        handleTinkerIoTMessage(frame, length, true);
+        inboundRing.pop();
+        if (drainMaxFrames && ++frames >= drainMaxFrames) break;
+    }
+}
+
+void TinkerIoTClass::wakeNetworkTask() {
+    #if defined(ESP32)
+    TaskHandle_t task = networkTask;
+    if (task) xTaskNotifyGive(task);
+    #else
+    TinkerIoTHost::linkWake();
+    #endif
+}
+
+TinkerIoTNetworkStats TinkerIoTClass::getNetworkStats() {
+    TinkerIoTNetworkStats stats;
+    stats.inboundFrames = inboundRing.pushed();
+    stats.inboundDropped = inboundRing.dropped();
+    stats.outboundFrames = outboundRing.pushed();
+    stats.outboundDropped = outboundRing.dropped();
+    stats.inboundPeak = inboundRing.peak();
+    stats.outboundPeak = outboundRing.peak();
+    return stats;
+}
+#endif
+
+// OPTIMIZED: Cloud write methods (Device → App) - REMOVED blocking delay
+// Check that a value may be sent (or stored, in coalescing mode)
+bool TinkerIoTClass::beginCloudWrite(int pin, bool storeOnly) {
+    if (pin < 0 || pin >= pinCount) {
+        TINKERIOT_COUNT(counters.droppedInvalidPin, 1);
+        TINKERIOT_LOGW(TINKERIOT_EV_INVALID_PIN, pin);
+        return false;
+    }
+    
+    // Coalesced writes are only stored here; flush() checks the connection
+    if (!storeOnly && !readyToSend()) {
+        if (linkState() == TINKERIOT_READY) {
+            TINKERIOT_COUNT(counters.droppedGrace, 1);
+        } else {
+            TINKERIOT_COUNT(counters.droppedNotConnected, 1);
+        }
+        TINKERIOT_LOGW(TINKERIOT_EV_CANNOT_SEND, pin);
+        return false;
+    }
+    return true;
+}
+
+// Connection is up, logged in and past the post-login grace period
+bool TinkerIoTClass::readyToSend() {
+    // Enhanced connection check - protect against sending during login phase
+    if (linkState() != TINKERIOT_READY) {
+        TINKERIOT_LOGD(TINKERIOT_EV_NOT_READY, linkState(), loginFailed ? 'Y' : 'N');
+        return false;
+    }
+    
+    // Add small grace period after login to ensure connection stability
+    if ((millis() - loginTime()) < 1000) {
+        TINKERIOT_LOGD(TINKERIOT_EV_GRACE);
+        return false;
+    }
+
+    return true;
+}
+
+// Numbers go out tagged once the server accepted binary values. Text stays
+// ASCII unless it starts with a byte that would read as a tag.
+void TinkerIoTClass::putValue(int pin, const char* value) {
+    size_t length = strlen(value);
+    if (binaryActive() && length > 0 && (uint8_t)value[0] <= TINKERIOT_TAG_RAW) {
+        txFrame.putTaggedRaw(value, length);
+    } else {
+        txFrame.putText(value, length);
+    }
+}
+
+void TinkerIoTClass::putValue(int pin, int value) {
+    if (binaryActive()) {
+        txFrame.putTaggedInt(value);
+    } else {
+        txFrame.putInt(value);
+    }
+}
+
+void TinkerIoTClass::putValue(int pin, double value) {
+    if (binaryActive()) {
+        txFrame.putTaggedFloat((float)value);
+    } else {
+        txFrame.putFixed(value, pinReports[pin].decimals);
+    }
+}
+
+// Stored values are copied out of the table first and formatted outside
+// the critical section
+void TinkerIoTClass::putValue(int pin, StoredValue stored) {
+    TinkerIoTPinValue value;
+    loadPin(stored.pin, value);
+    putValue(pin, value);
+}
+
+void TinkerIoTClass::putValue(int pin, const TinkerIoTPinValue& value) {
+    switch (value.type) {
+        case TINKERIOT_VALUE_INT:
+            putValue(pin, (int)value.asInt);
+            break;
+        case TINKERIOT_VALUE_FLOAT:
+            putValue(pin, (double)value.asFloat);
+            break;
+        case TINKERIOT_VALUE_TEXT:
+            if (binaryActive() && value.length > 0 && (uint8_t)value.text[0] <= TINKERIOT_TAG_RAW) {
+                txFrame.putTaggedRaw(value.text, value.length);
+            } else {
+                txFrame.putText(value.text, value.length);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// ===== CLOUD PIN STORAGE =====
+
+// A slot is slotWords words: the version, then the value's first words
+// (through text[valueLength]). They are copied with relaxed atomic
+// accesses: a reader may overlap a writer, and the version check below
+// discards what it copied then.
+void TinkerIoTClass::storePin(int pin, uint8_t type, const void* data, size_t length, bool markDirty) {
+    if (type == TINKERIOT_VALUE_TEXT && length > valueLength) length = valueLength;
+
+    // Build the new value outside the critical section
+    TinkerIoTPinWords update;
+    memset(update.words, 0, sizeof(update.words));
+    update.value.type = type;
+    update.value.length = length;
+    memcpy(update.value.text, data, length);
+
+    // CRITICAL SECTION: one writer per slot, for a fixed-size copy
+    TINKERIOT_LOCK(pinWriteMutex);
+    uint32_t* slot = cloudPins + (size_t)pin * slotWords;
+    uint32_t version = slot[0];
+    __atomic_store_n(&slot[0], version + 1, __ATOMIC_RELAXED);  // Odd: write in progress
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (size_t i = 1; i < slotWords; i++) {
+        __atomic_store_n(&slot[i], update.words[i - 1], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot[0], version + 2, __ATOMIC_RELEASE);
+    if (markDirty) {
+        dirtyPins[pin / 32] |= (1UL << (pin % 32));
+    }
+    TINKERIOT_UNLOCK(pinWriteMutex);
+}
+
+void TinkerIoTClass::loadPin(int pin, TinkerIoTPinValue& out) {
+    uint32_t* slot = cloudPins + (size_t)pin * slotWords;
+    TinkerIoTPinWords copy;
+    for (;;) {
+        uint32_t version = __atomic_load_n(&slot[0], __ATOMIC_ACQUIRE);
+        if (version & 1) continue;  // A writer is mid-copy (on another core or task)
+        for (size_t i = 1; i < slotWords; i++) {
+            copy.words[i - 1] = __atomic_load_n(&slot[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot[0], __ATOMIC_RELAXED) == version) break;
+    }
+    out = copy.value;
+}
+
+// Append cw\0<pin>\0<value> to txFrame - either as a new frame or as the
+// next tuple of the open batch. When the batch is full it is sent and the
+// tuple is retried at the start of a fresh frame.
+template <typename T>
+bool TinkerIoTClass::appendPinValue(int pin, T value, size_t& valueStart) {
+    for (;;) {
+        size_t tupleStart = txFrame.length();
+        if (batchOpen && batchCount > 0) {
+            txFrame.putSeparator();
+        } else {
+            txFrame.begin(HARDWARE, ackWindow ? nextMsgId() : 0);
+            frameReliable = false;
+        }
+        txFrame.putCloudWriteHeader(pin);
+        valueStart = txFrame.length();
+        putValue(pin, value);
+
+        if (!txFrame.overflowed()) {
+            if (batchOpen) batchCount++;
+            if (pinReports[pin].reliable && ackWindow) {
+                pinReports[pin].pendingId = txFrame.msgId();  // Settled by the frame's RESPONSE
+                frameReliable = true;
+            }
+            return true;
+        }
+        if (!batchOpen || batchCount == 0) {
+            TINKERIOT_LOGE(TINKERIOT_EV_VALUE_TOO_LONG, pin);
+            return false;
+        }
+        txFrame.rewind(tupleStart);
+        sendBatchFrame();
+    }
+}
+
+// Shared body of the cloudWrite overloads. Returns true if the value was
+// sent, batched or (in coalescing mode) stored for the next flush.
+// Text longer than a pin slot holds is only ever sent as it is written:
+// it cannot be queued, deferred or coalesced, and is dropped (logged as
+// VALUE_TOO_LONG) when it cannot go out right away.
+template <typename T>
+bool TinkerIoTClass::writePin(int pin, T value) {
+    bool fits = fitsSlot(value);
+    if (pin == echoCapturePin && fits) {
+        storePin(pin, value);
+        echoCaptured = true;
+        return true;  // Sent as the echo, see cloudRead()
+    }
+    if (holdOffline(pin)) {
+        if (!fits) {
+            TINKERIOT_LOGE(TINKERIOT_EV_VALUE_TOO_LONG, pin);
+            return false;
+        }
+        storePin(pin, value);
+        bufferValue(pin, value);
+        return true;  // Sent by replayOffline()
+    }
+    bool coalesce = coalesceWrites && fits;
+    if (!beginCloudWrite(pin, coalesce)) return false;
+
+    // Coalesced values are stored as-is and formatted once, at flush time.
+    // So are values the send window has no room for, and values that would
+    // overtake ones it already held back.
+    bool defer = !coalesce && (deferredPins || !sendWindowOpen());
+    if (defer && !fits) {
+        TINKERIOT_LOGE(TINKERIOT_EV_VALUE_TOO_LONG, pin);
+        return false;
+    }
+    storePin(pin, value, coalesce || defer);
+    if (coalesce) {
+        return true;  // Sent by the next flush()
+    }
+    if (!fits) {
+        // The value sent now is newer than whatever a flush would send
+        TINKERIOT_LOCK(pinWriteMutex);
+        dirtyPins[pin / 32] &= ~(1UL << (pin % 32));
+        TINKERIOT_UNLOCK(pinWriteMutex);
+    }
+    if (defer) {
+        deferredPins = true;
+        ackStats.deferred++;
+        return true;  // Sent by run() once the window opens
+    }
+
+    size_t valueStart;
+    if (!appendPinValue(pin, value, valueStart)) return false;
+    if (batchOpen) {
+        return true;  // Sent by commitBatch()
+    }
+
+    // Send to server
+    TINKERIOT_LOGD(TINKERIOT_EV_CLOUD_WRITE, pin, txFrame.length() - valueStart, txFrame.msgId());
+    if (txFrame.finish() != 0) {
+        sendFrame(txFrame);
+        frameSent();
+    }
+
+    // PRIORITY FIX: Yield CPU to allow incoming widget commands to be processed
+    // This prevents sensor sends from blocking button commands
+    yield();
+    return true;
+}
+
+// Numeric writes go through the pin's reporting policy before any
+// formatting happens, so suppressed values cost a compare and a return
+template <typename T>
+void TinkerIoTClass::writeNumber(int pin, T value) {
+    if (!shouldReport(pin, value)) return;
+    if (writePin(pin, value) && pinReports[pin].active) {
+        pinReports[pin].lastSent = value;
+        pinReports[pin].lastSentAt = millis();
+        pinReports[pin].hasSent = true;
+    }
+}
+
+void TinkerIoTClass::cloudWrite(int pin, const char* value) {
+    writePin(pin, value);
+}
+
+void TinkerIoTClass::cloudWrite(int pin, String value) {
+    writePin(pin, value.c_str());
+}
+
+void TinkerIoTClass::cloudWrite(int pin, int value) {
+    writeNumber(pin, value);
+}
+
+void TinkerIoTClass::cloudWrite(int pin, float value) {
+    writeNumber(pin, (double)value);
+}
+
+void TinkerIoTClass::cloudWrite(int pin, double value) {
+    writeNumber(pin, value);
+}
+
+// ===== REPORTING POLICIES =====
+
+void TinkerIoTClass::setReportPolicy(int pin, const TinkerIoTReportPolicy& policy) {
+    if (pin < 0 || pin >= pinCount) return;
+    pinReports[pin].policy = policy;
+    pinReports[pin].hasSent = false;
+    pinReports[pin].active = true;
+    if (policy.maxSilence > 0) {
+        silenceWatch = true;
+        silenceDue = millis();
+    }
+}
+
+void TinkerIoTClass::clearReportPolicy(int pin) {
+    if (pin < 0 || pin >= pinCount) return;
+    pinReports[pin].active = false;
+}
+
+void TinkerIoTClass::setPrecision(int pin, uint8_t decimals) {
+    if (pin < 0 || pin >= pinCount) return;
+    pinReports[pin].decimals = decimals > 9 ? 9 : decimals;
+}
+
+// Decide whether a numeric value should be sent under the pin's policy
+bool TinkerIoTClass::shouldReport(int pin, double value) {
+    if (pin < 0 || pin >= pinCount) return true;  // writePin reports the bad pin
+    const TinkerIoTPinReport& report = pinReports[pin];
+    if (!report.active || !report.hasSent) return true;
+
+    const TinkerIoTReportPolicy& policy = report.policy;
+    unsigned long elapsed = millis() - report.lastSentAt;
+    if (policy.maxSilence > 0 && elapsed >= policy.maxSilence) return true;
+    if (policy.minInterval > 0 && elapsed < policy.minInterval) return false;
+
+    double band = policy.deadband;
+    if (policy.deadbandPercent) {
+        band = fabs(report.lastSent) * policy.deadband / 100.0;
+    }
+    return fabs(value - report.lastSent) > band;
+}
+
+// Heartbeat: resend the stored value of every pin whose maxSilence expired
+void TinkerIoTClass::sendSilentPins() {
+    unsigned long now = millis();
+    unsigned long nextDue = now + 1000;  // Re-check at least once a second
+    bool watching = false;
+    int ready = -1;                      // readyToSend(), asked once a pin is due
+
+    // 32 pins at a time, as a bit set per word
+    for (int first = 0; first < pinCount; first += 32) {
+        uint32_t due = 0;
+        for (int bit = 0; bit < 32 && first + bit < pinCount; bit++) {
+            TinkerIoTPinReport& report = pinReports[first + bit];
+            if (!report.active || report.policy.maxSilence == 0) continue;
+            watching = true;
+            if (!report.hasSent) continue;
+
+            unsigned long pinDue = report.lastSentAt + report.policy.maxSilence;
+            if ((long)(now - pinDue) >= 0) {
+                due |= (1UL << bit);
+                pinDue = now + report.policy.maxSilence;
+            }
+            if ((long)(pinDue - nextDue) < 0) nextDue = pinDue;
+        }
+        if (due == 0) continue;
+
+        if (ready < 0) {
+            ready = readyToSend();
+            if (ready) openBatch();
+        }
+        if (!ready) continue;
+        due &= ~sendPins(first, due);  // Pins the window had no room for stay due
+        for (int bit = 0; due != 0; bit++, due >>= 1) {
+            if (due & 1) pinReports[first + bit].lastSentAt = now;
+        }
+    }
+    commitBatch();
+
+    silenceWatch = watching;
+    silenceDue = nextDue;
+}
+
+// ===== BATCHED WRITES =====
+// Between beginBatch() and commitBatch(), cloudWrite appends its tuple to
+// one HARDWARE frame: cw\0<pin>\0<value>\0cw\0<pin>\0<value>...
+// A batch that outgrows the transmit buffer is split into several frames.
+void TinkerIoTClass::beginBatch() {
+    if (coalesceWrites) return;  // flush() already batches coalesced pins
+    if (batchOpen) commitBatch();
+    batchOpen = true;
+    batchCount = 0;
+}
+
+void TinkerIoTClass::commitBatch() {
+    if (!batchOpen) return;
+    sendBatchFrame();
+    batchOpen = false;
+}
+
+// Send the tuples collected so far (if any) and start counting afresh
+void TinkerIoTClass::sendBatchFrame() {
+    if (batchCount > 0 && txFrame.finish() != 0) {
+        TINKERIOT_LOGD(TINKERIOT_EV_BATCH_SENT, batchCount);
+        sendFrame(txFrame);
+        frameSent();
+    }
+    batchCount = 0;
+}
+
+// Enable/disable coalescing mode. Disabling sends whatever is still dirty,
+// or leaves it to run() when the connection is not usable yet.
+void TinkerIoTClass::setCoalescing(bool enabled, unsigned long flushIntervalMs) {
+    commitBatch();
+    coalesceInterval = flushIntervalMs;
+    if (coalesceWrites && !enabled) {
+        flush();
+        if (hasDirtyPins()) deferredPins = true;
+    }
+    coalesceWrites = enabled;
+}
+
+// Send the latest value of every dirty pin, packed into as few frames as fit
+void TinkerIoTClass::flush() {
+    if (!readyToSend()) return;  // Pins stay dirty until the connection is usable
+    commitBatch();
+
+    openBatch();
+    for (int first = 0; first < pinCount; first += 32) {
+        // CRITICAL SECTION: take ownership of this word of the dirty set
+        TINKERIOT_LOCK(pinWriteMutex);
+        uint32_t pending = dirtyPins[first / 32];
+        dirtyPins[first / 32] = 0;
+        TINKERIOT_UNLOCK(pinWriteMutex);
+
+        uint32_t left = sendPins(first, pending);
+        if (left) {
+            TINKERIOT_LOCK(pinWriteMutex);
+            dirtyPins[first / 32] |= left;  // Wait for the window to open
+            TINKERIOT_UNLOCK(pinWriteMutex);
+        }
+    }
+    commitBatch();
+    deferredPins = deferredPins && hasDirtyPins();
+}
+
+// ===== STORE AND FORWARD =====
+
+bool TinkerIoTClass::enableOfflineBuffer(uint16_t entries, TinkerIoTOfflineStore* store) {
+    if (entries == 0) return false;
+    size_t recordSize = offlineRecordSize();
+    if (store && !store->begin(recordSize, offlineLayout())) {
+        #ifdef TINKERIOT_PRINT
+        TINKERIOT_PRINT.println("❌ Offline store could not be opened - buffering in RAM only");
+        #endif
+        store = nullptr;
+    }
+    return offlineQueue.init(entries, recordSize, store);
+}
+
+void TinkerIoTClass::setOfflineReplay(uint8_t valuesPerFrame, unsigned long intervalMs) {
+    replayBatch = valuesPerFrame > 0 ? valuesPerFrame : 1;
+    replayInterval = intervalMs;
+}
+
+TinkerIoTOfflineStats TinkerIoTClass::getOfflineStats() {
+    TinkerIoTOfflineStats stats;
+    stats.depth = offlineQueue.enabled() ? offlineQueue.depth() : 0;
+    stats.stored = offlineQueue.enabled() ? offlineQueue.stored() : 0;
+    stats.buffered = offlineBuffered;
+    stats.dropped = offlineQueue.dropped;
+    stats.replayed = offlineReplayed;
+    stats.replayBacklog = replayBacklog;
+    stats.replaySent = replaySent;
+    stats.oldestAgeMs = 0;
+
+    uint8_t record[8 + TINKERIOT_MAX_VALUE_LEN + 4];
+    if (stats.depth > 0 && offlineQueue.read(0, record)) {
+        uint32_t at;
+        memcpy(&at, record + 4, sizeof(at));
+        stats.oldestAgeMs = millis() - at;
+    }
+    return stats;
+}
+
+// Queue instead of sending: the connection is not usable, or older values
+// are still waiting and this one must not overtake them
+bool TinkerIoTClass::holdOffline(int pin) {
+    if (!offlineQueue.enabled() || coalesceWrites || pin < 0 || pin >= pinCount) return false;
+    return offlineQueue.depth() > 0 || linkState() != TINKERIOT_READY || millis() - loginTime() < 1000;
+}
+
+void TinkerIoTClass::bufferValue(int pin, uint8_t type, const void* data, size_t length) {
+    if (type == TINKERIOT_VALUE_TEXT && length > valueLength) length = valueLength;
+
+    uint8_t record[8 + TINKERIOT_MAX_VALUE_LEN + 4];
+    uint32_t now = millis();
+    memset(record, 0, offlineRecordSize());
+    record[0] = (pin >> 8) & 0xFF;
+    record[1] = pin & 0xFF;
+    record[2] = type;
+    record[3] = length;
+    memcpy(record + 4, &now, sizeof(now));
+    memcpy(record + 8, data, length);
+    offlineQueue.push(record);
+    offlineBuffered++;
+
+    TINKERIOT_LOGD(TINKERIOT_EV_BUFFERED, pin, offlineQueue.depth());
+}
+
+// Earliest time for the next replay frame: one interval after the last,
+// and not before the post-login grace period is over
+unsigned long TinkerIoTClass::replayDue() {
+    unsigned long due = lastReplay + replayInterval;
+    unsigned long graceEnd = loginTime() + 1000;
+    return (long)(graceEnd - due) > 0 ? graceEnd : due;
+}
+
+// Send the oldest replayBatch values as one frame
+void TinkerIoTClass::replayOffline() {
+    uint32_t depth = offlineQueue.depth();
+    if (depth == 0 || !readyToSend()) return;
+    if (!replaying) {
+        replaying = true;
+        replayBacklog = depth;
+        replaySent = 0;
+        #ifdef TINKERIOT_PRINT
+        TINKERIOT_PRINT.print("📼 Replaying ");
+        TINKERIOT_PRINT.print(depth);
+        TINKERIOT_PRINT.println(" buffered values");
+        #endif
+    }
+    lastReplay = millis();
+
+    openBatch();
+    uint8_t record[8 + TINKERIOT_MAX_VALUE_LEN + 4];
+    uint32_t sent = 0, skipped = 0;
+    while (sent < replayBatch && sendWindowOpen() && offlineQueue.read(sent, record)) {
+        sent++;
+        int pin = (record[0] << 8) | record[1];
+        TinkerIoTPinValue value;
+        value.type = record[2];
+        value.length = record[3];
+        // A store outlives the sketch: skip what this build did not write
+        bool text = value.type == TINKERIOT_VALUE_TEXT;
+        if (pin >= pinCount || value.type < TINKERIOT_VALUE_INT || value.type > TINKERIOT_VALUE_TEXT ||
+            (text && value.length > valueLength)) {
+            skipped++;
+            TINKERIOT_LOGE(TINKERIOT_EV_BAD_RECORD, pin, value.type, value.length);
+            continue;
+        }
+        memcpy(value.text, record + 8, text ? value.length : 4);
+        if (text) value.text[value.length] = '\0';
+
+        size_t valueStart;
+        appendPinValue(pin, value, valueStart);
+    }
+    commitBatch();
+    offlineQueue.pop(sent);
+    offlineQueue.dropped += skipped;
+    offlineReplayed += sent - skipped;
+    replaySent += sent;
+
+    if (offlineQueue.depth() == 0) {
+        replaying = false;
+        #ifdef TINKERIOT_PRINT
+        TINKERIOT_PRINT.println("📼 Replay complete");
+        #endif
+    }
+}
+
+bool TinkerIoTOfflineQueue::init(uint16_t capacity, uint16_t recordSize, TinkerIoTOfflineStore* store) {
+    uint8_t* storage = (uint8_t*)realloc(_records, (size_t)capacity * recordSize);
+    if (!storage) return false;
+    _records = storage;
+    _capacity = capacity;
+    _recordSize = recordSize;
+    _head = _tail = 0;
+    _store = store;
+    return true;
+}
+
+void TinkerIoTOfflineQueue::push(const uint8_t* record) {
+    if (_head - _tail >= _capacity) {
+        // Full: the oldest RAM record moves to the store, or is lost
+        if (!_store || !_store->push(slot(_tail))) dropped++;
+        _tail++;
+    }
+    memcpy(slot(_head), record, _recordSize);
+    _head++;
+}
+
+bool TinkerIoTOfflineQueue::read(uint32_t index, uint8_t* record) {
+    uint32_t inStore = stored();
+    if (index < inStore) return _store->read(index, record);
+    index -= inStore;
+    if (index >= _head - _tail) return false;
+    memcpy(record, slot(_tail + index), _recordSize);
+    return true;
+}
+
+void TinkerIoTOfflineQueue::pop(uint32_t count) {
+    uint32_t inStore = stored();
+    if (inStore > 0) {
+        uint32_t fromStore = count < inStore ? count : inStore;
+        _store->pop(fromStore);
+        count -= fromStore;
+    }
+    uint32_t inRam = _head - _tail;
+    _tail += count < inRam ? count : inRam;
+}
+
+// File layout: [record size, 4][layout, 4][records replayed, 4][records...]
+#define TINKERIOT_FILE_HEADER 12
+
+TinkerIoTFileStore::~TinkerIoTFileStore() {
+    #if defined(ESP32) || defined(ESP8266)
+    if (_file) _file.close();
+    #elif defined(TINKERIOT_HOST)
+    if (_file) fclose(_file);
+    #endif
+}
+
+bool TinkerIoTFileStore::open(bool truncate) {
+    #if defined(ESP32) || defined(ESP8266)
+    if (_file) _file.close();
+    if (!truncate && _fs.exists(_path)) {
+        _file = _fs.open(_path, "r+");
+    } else {
+        _file = _fs.open(_path, "w+");
+    }
+    return (bool)_file;
+    #elif defined(TINKERIOT_HOST)
+    if (_file) fclose(_file);
+    _file = truncate ? nullptr : fopen(_path, "r+b");
+    if (!_file) _file = fopen(_path, "w+b");
+    return _file != nullptr;
+    #else
+    return false;
+    #endif
+}
+
+bool TinkerIoTFileStore::writeAt(uint32_t offset, const uint8_t* data, size_t length) {
+    #if defined(ESP32) || defined(ESP8266)
+    if (!_file.seek(offset, fs::SeekSet) || _file.write(data, length) != length) return false;
+    _file.flush();
+    return true;
+    #elif defined(TINKERIOT_HOST)
+    return fseek(_file, offset, SEEK_SET) == 0 && fwrite(data, 1, length, _file) == length && fflush(_file) == 0;
+    #else
+    return false;
+    #endif
+}
+
+bool TinkerIoTFileStore::readAt(uint32_t offset, uint8_t* data, size_t length) {
+    #if defined(ESP32) || defined(ESP8266)
+    return _file.seek(offset, fs::SeekSet) && _file.read(data, length) == length;
+    #elif defined(TINKERIOT_HOST)
+    return fseek(_file, offset, SEEK_SET) == 0 && fread(data, 1, length, _file) == length;
+    #else
+    return false;
+    #endif
+}
+
+uint32_t TinkerIoTFileStore::fileSize() {
+    #if defined(ESP32) || defined(ESP8266)
+    return _file.size();
+    #elif defined(TINKERIOT_HOST)
+    if (fseek(_file, 0, SEEK_END) != 0) return 0;
+    return (uint32_t)ftell(_file);
+    #else
+    return 0;
+    #endif
+}
+
+bool TinkerIoTFileStore::writeHeader() {
+    uint8_t header[TINKERIOT_FILE_HEADER];
+    memcpy(header, &_recordSize, 4);
+    memcpy(header + 4, &_layout, 4);
+    memcpy(header + 8, &_first, 4);
+    return writeAt(0, header, sizeof(header));
+}
+
+// Resume a backlog left by the previous boot if it was written with the
+// same record size and layout; start afresh otherwise
+bool TinkerIoTFileStore::begin(size_t recordSize, uint32_t layout) {
+    _recordSize = recordSize;
+    _layout = layout;
+    _first = 0;
+    _records = 0;
+    if (!open(false)) return false;
+
+    uint8_t header[TINKERIOT_FILE_HEADER];
+    uint32_t size = fileSize();
+    uint32_t savedSize = 0, savedLayout = 0;
+    if (size >= sizeof(header) && readAt(0, header, sizeof(header))) {
+        memcpy(&savedSize, header, 4);
+        memcpy(&savedLayout, header + 4, 4);
+        memcpy(&_first, header + 8, 4);
+    }
+    if (savedSize == recordSize && savedLayout == layout) {
+        _records = (size - sizeof(header)) / recordSize;
+        if (_first <= _records) return true;
+    }
+    _first = 0;
+    _records = 0;
+    return open(true) && writeHeader();
+}
+
+bool TinkerIoTFileStore::push(const uint8_t* record) {
+    if (count() >= _maxRecords) return false;
+    if (!writeAt(TINKERIOT_FILE_HEADER + _records * _recordSize, record, _recordSize)) return false;
+    _records++;
+    return true;
+}
+
+bool TinkerIoTFileStore::read(uint32_t index, uint8_t* record) {
+    if (index >= count()) return false;
+    return readAt(TINKERIOT_FILE_HEADER + (_first + index) * _recordSize, record, _recordSize);
+}
+
+void TinkerIoTFileStore::pop(uint32_t count) {
+    _first += count;
+    if (_first >= _records) {
+        // Everything replayed: give the space back
+        _first = 0;
+        _records = 0;
+        if (open(true)) writeHeader();
+    } else {
+        writeHeader();
+    }
+}
+
+// ===== ACKNOWLEDGED SENDS =====
+
+void TinkerIoTClass::setAckWindow(uint8_t frames, unsigned long timeoutMs) {
+    commitBatch();
+    ackWindow = frames > ackCapacity ? ackCapacity : frames;
+    ackTimeout = timeoutMs;
+}
+
+void TinkerIoTClass::setReliable(int pin, bool reliable) {
+    if (pin < 0 || pin >= pinCount) return;
+    pinReports[pin].reliable = reliable;
+    pinReports[pin].pendingId = 0;
+}
+
+TinkerIoTAckStats TinkerIoTClass::getAckStats() {
+    TinkerIoTAckStats stats = ackStats;
+    stats.inFlight = inFlightCount;
+    stats.sendInterval = sendInterval;
+    return stats;
+}
+
+// 0 means "no answer expected" and 1 is LOGIN's. PING probes take ids from
+// here too.
+uint16_t TinkerIoTClass::nextMsgId() {
+    if (++lastMsgId < 2) lastMsgId = 2;
+    return lastMsgId;
+}
+
+// Whether another cw tuple may go out now: the window has a slot for the
+// frame it lands in (two when joining an open batch, which may split) and
+// the QUOTA_LIMIT pacing lets a new frame start
+bool TinkerIoTClass::sendWindowOpen() {
+    bool joining = batchOpen && batchCount > 0;
+    if (ackWindow && inFlightCount + (joining ? 2 : 1) > ackWindow) return false;
+    return joining || sendInterval == 0 || millis() - lastFrameSent >= sendInterval;
+}
+
+// txFrame went out as a HARDWARE frame: start the pacing interval and,
+// if it has a message id, wait for its RESPONSE
+void TinkerIoTClass::frameSent() {
+    lastFrameSent = millis();
+    uint16_t msg_id = txFrame.msgId();
+    if (msg_id == 0) {
+        // Untracked: every frame the server did not refuse so far counts
+        if (sendInterval > 0) sendInterval -= sendInterval / 8 + 1;
+        return;
+    }
+
+    for (uint8_t i = 0; i < ackCapacity; i++) {
+        if (inFlight[i].msgId == 0) {
+            inFlight[i].msgId = msg_id;
+            inFlight[i].reliable = frameReliable;
+            inFlight[i].sentAt = lastFrameSent;
+            inFlightCount++;
+            ackStats.sent++;
+            return;
+        }
+    }
+}
+
+void TinkerIoTClass::handleAck(uint16_t msg_id, uint8_t status) {
+    if (msg_id != 0 && msg_id == probeId) {
+        latency.lastRttMicros = micros() - probeSentAt;
+        latency.rtt.add(latency.lastRttMicros);
+        probeId = 0;
+        return;
+    }
+    if (status == QUOTA_LIMIT) {
+        ackStats.quotaLimited++;
+        // One burst of refusals doubles the interval once
+        unsigned long now = millis();
+        if (sendInterval == 0) {
+            sendInterval = TINKERIOT_QUOTA_BACKOFF_MS;
+        } else if (now - lastQuotaLimit >= sendInterval) {
+            sendInterval = sendInterval * 2 > TINKERIOT_QUOTA_MAX_INTERVAL_MS ? TINKERIOT_QUOTA_MAX_INTERVAL_MS
+                                                                             : sendInterval * 2;
+        }
+        lastQuotaLimit = now;
+        TINKERIOT_LOGI(TINKERIOT_EV_QUOTA_LIMIT, sendInterval);
+    }
+    if (msg_id == 0) return;
+
+    for (uint8_t i = 0; i < ackCapacity; i++) {
+        TinkerIoTInFlight& frame = inFlight[i];
+        if (frame.msgId != msg_id) continue;
+        frame.msgId = 0;
+        inFlightCount--;
+        if (status == SUCCESS) {
+            ackStats.acked++;
+            if (sendInterval > 0) sendInterval -= sendInterval / 8 + 1;
+        } else if (status != QUOTA_LIMIT) {
+            ackStats.rejected++;  // Sending it again would be refused again
+        }
+        if (frame.reliable) settlePins(msg_id, status == QUOTA_LIMIT);
+        return;
+    }
+    // No match: a frame already given up on
+}
+
+// Frames whose RESPONSE is overdue, or that were in flight when the
+// connection dropped, are lost
+void TinkerIoTClass::expireAcks() {
+    unsigned long now = millis();
+    bool dropped = linkState() != TINKERIOT_READY;
+    for (uint8_t i = 0; i < ackCapacity; i++) {
+        TinkerIoTInFlight& frame = inFlight[i];
+        if (frame.msgId == 0 || (!dropped && now - frame.sentAt < ackTimeout)) continue;
+        TINKERIOT_LOGW(TINKERIOT_EV_ACK_TIMEOUT, frame.msgId);
+        uint16_t msg_id = frame.msgId;
+        frame.msgId = 0;
+        inFlightCount--;
+        ackStats.timedOut++;
+        if (frame.reliable) settlePins(msg_id, true);
+    }
+}
+
+unsigned long TinkerIoTClass::ackDue() {
+    unsigned long now = millis();
+    unsigned long due = now + ackTimeout;
+    for (uint8_t i = 0; i < ackCapacity; i++) {
+        if (inFlight[i].msgId && (long)(inFlight[i].sentAt + ackTimeout - due) < 0) {
+            due = inFlight[i].sentAt + ackTimeout;
+        }
+    }
+    return due;
+}
+
+// The frame msg_id was answered or lost. Its reliable pins are done, or -
+// unless a later frame carries them already - marked dirty so that their
+// current value goes out again.
+void TinkerIoTClass::settlePins(uint16_t msg_id, bool resend) {
+    for (uint16_t pin = 0; pin < pinCount; pin++) {
+        if (pinReports[pin].pendingId != msg_id) continue;
+        pinReports[pin].pendingId = 0;
+        if (!resend) continue;
+        TINKERIOT_LOCK(pinWriteMutex);
+        dirtyPins[pin / 32] |= (1UL << (pin % 32));
+        TINKERIOT_UNLOCK(pinWriteMutex);
+        deferredPins = true;
+        ackStats.retransmits++;
+    }
+}
+
+// ===== ECHO =====
+
+void TinkerIoTClass::setEchoPolicy(int pin, TinkerIoTEchoPolicy policy) {
+    if (pin < 0 || pin >= pinCount) return;
+    pinReports[pin].echo = policy;
+}
+
+void TinkerIoTClass::setEchoPolicy(TinkerIoTEchoPolicy policy) {
+    for (uint16_t pin = 0; pin < pinCount; pin++) {
+        pinReports[pin].echo = policy;
+    }
+}
+
+void TinkerIoTClass::setEchoInterval(unsigned long intervalMs) {
+    echoInterval = intervalMs;
+}
+
+// Leave the pin dirty for the next coalesced echo
+void TinkerIoTClass::markEcho(int pin) {
+    TINKERIOT_LOCK(pinWriteMutex);
+    dirtyPins[pin / 32] |= (1UL << (pin % 32));
+    echoPins[pin / 32] |= (1UL << (pin % 32));
+    TINKERIOT_UNLOCK(pinWriteMutex);
+    if (!echoPending) {
+        echoPending = true;
+        echoMarkedAt = millis();
+    }
+}
+
+// Send the marked echoes in one frame. Other dirty pins (coalescing mode)
+// keep waiting for their flush interval; what a full window holds back
+// stays marked for the next run() that finds it open.
+void TinkerIoTClass::flushEchoes() {
+    if (!readyToSend()) return;
+    echoPending = false;
+    openBatch();
+    for (int first = 0; first < pinCount; first += 32) {
+        TINKERIOT_LOCK(pinWriteMutex);
+        uint32_t pending = dirtyPins[first / 32] & echoPins[first / 32];
+        dirtyPins[first / 32] &= ~pending;
+        echoPins[first / 32] = 0;
+        TINKERIOT_UNLOCK(pinWriteMutex);
+
+        uint32_t left = pending ? sendPins(first, pending) : 0;
+        if (left) {
+            TINKERIOT_LOCK(pinWriteMutex);
+            dirtyPins[first / 32] |= left;
+            echoPins[first / 32] |= left;
+            TINKERIOT_UNLOCK(pinWriteMutex);
+            echoPending = true;  // Still due: echoMarkedAt is unchanged
+        }
+    }
+    commitBatch();
+}
+
+// When the coalesced echoes go out: echoInterval after the first was
+// marked, and not within the post-login grace period
+unsigned long TinkerIoTClass::echoDue() {
+    unsigned long due = echoMarkedAt + echoInterval;
+    unsigned long graceEnd = loginTime() + 1000;
+    return (long)(graceEnd - due) > 0 ? graceEnd : due;
+}
+
+// ===== LATENCY =====
+
+uint32_t TinkerIoTHistogram::percentile(uint8_t percent) const {
+    if (count == 0) return 0;
+    uint32_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < TINKERIOT_LATENCY_BUCKETS - 1; bucket++) {
+        seen += buckets[bucket];
+        if (seen >= rank && seen > 0) {
+            uint32_t edge = 64UL << bucket;
+            return edge < maxMicros ? edge : maxMicros;
+        }
+    }
+    return maxMicros;
+}
+
+void TinkerIoTClass::setLatencyProbe(unsigned long intervalMs) {
+    probeInterval = intervalMs;
+    lastProbe = millis() - intervalMs;  // First PING on the next run()
+}
+
+void TinkerIoTClass::setLatencyReport(int pin, unsigned long intervalMs) {
+    latencyPin = pin >= 0 && pin < pinCount ? pin : -1;
+    latencyInterval = intervalMs;
+    lastLatencyReport = millis();
+}
+
+TinkerIoTHandlerTiming TinkerIoTClass::getHandlerTiming(int pin) {
+    TinkerIoTHandlerTiming none = {0, 0, 0};
+    return pin >= 0 && pin < pinCount ? handlerTimings[pin] : none;
+}
+
+void TinkerIoTClass::resetLatencyStats() {
+    memset(&latency, 0, sizeof(latency));
+    memset(handlerTimings, 0, pinCount * sizeof(TinkerIoTHandlerTiming));
+}
+
+// One PING with its own message id; the RESPONSE is matched in handleAck()
+void TinkerIoTClass::sendProbe() {
+    if (probeId) latency.probesLost++;  // The previous one was never answered
+    probeId = nextMsgId();
+    probeSentAt = micros();
+    latency.probes++;
+    uint8_t frame[5] = { PING, (uint8_t)(probeId >> 8), (uint8_t)(probeId & 0xFF), 0, 0 };
+    transmit(frame, sizeof(frame));
+}
+
+// Decimal digits of magnitude at buffer[length], as far as they fit with a NUL
+static size_t appendNumber(char* buffer, size_t size, size_t length, uint32_t magnitude, bool negative) {
+    char digits[11];
+    int count = 0;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+    if (negative && length + 1 < size) buffer[length++] = '-';
+    while (count > 0 && length + 1 < size) buffer[length++] = digits[--count];
+    return length;
+}
+
+// "<rtt p50>,<rtt p99>,<rtt max>,<handler p99>,<handler max>" on latencyPin,
+// whole fields only when it is longer than a pin value may be
+void TinkerIoTClass::publishLatency() {
+    uint32_t fields[5] = {
+        (latency.rtt.percentile(50) + 500) / 1000,
+        (latency.rtt.percentile(99) + 500) / 1000,
+        (latency.rtt.maxMicros + 500) / 1000,
+        latency.handler.percentile(99),
+        latency.handler.maxMicros,
+    };
+    char report[5 * 11];  // Five numbers of up to 10 digits, four commas, NUL
+    size_t length = 0;
+    for (int i = 0; i < 5; i++) {
+        if (i > 0) report[length++] = ',';
+        length = appendNumber(report, sizeof(report), length, fields[i], false);
+    }
+    report[length] = '\0';
+
+    if (length > valueLength) {
+        size_t cut = valueLength;
+        while (cut > 0 && report[cut] != ',') cut--;
+        latency.reportsCut++;
+        TINKERIOT_LOGW(TINKERIOT_EV_REPORT_CUT, latencyPin, length, cut);
+        if (cut == 0) return;  // Not even the first field fits
+        report[cut] = '\0';
+    }
+    cloudWrite(latencyPin, report);
+}
+
+// ===== STATS =====
+
+static uint8_t statsCommand(uint8_t command) {
+    switch (command) {
+        case RESPONSE: return TINKERIOT_STATS_RESPONSE;
+        case LOGIN:    return TINKERIOT_STATS_LOGIN;
+        case PING:     return TINKERIOT_STATS_PING;
+        case HARDWARE: return TINKERIOT_STATS_HARDWARE;
+        default:       return TINKERIOT_STATS_OTHER;
+    }
+}
+
+void TinkerIoTClass::countFrame(TinkerIoTTraffic* traffic, const uint8_t* frame, size_t length) {
+    TinkerIoTTraffic& command = traffic[statsCommand(frame[0])];
+    TINKERIOT_COUNT(command.frames, 1);
+    TINKERIOT_COUNT(command.bytes, length);
+}
+
+void TinkerIoTClass::sampleHeap() {
+    #if defined(ESP32)
+    counters.minFreeHeap = ESP.getMinFreeHeap();
+    counters.largestFreeBlock = ESP.getMaxAllocHeap();
+    #elif defined(ESP8266)
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (counters.minFreeHeap == 0 || freeHeap < counters.minFreeHeap) counters.minFreeHeap = freeHeap;
+    counters.largestFreeBlock = ESP.getMaxFreeBlockSize();
+    #endif
+}
+
+// Field by field: each one is current, the set is not one instant
+TinkerIoTStats TinkerIoTClass::getStats() {
+    sampleHeap();
+    TinkerIoTStats snapshot;
+    const uint32_t* from = (const uint32_t*)&counters;
+    uint32_t* to = (uint32_t*)&snapshot;
+    for (size_t i = 0; i < TINKERIOT_STATS_FIELDS; i++) {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+    return snapshot;
+}
+
+size_t TinkerIoTClass::exportStats(uint8_t* buffer, size_t size) {
+    if (size < 2) return 0;
+    TinkerIoTStats snapshot = getStats();
+    const uint32_t* fields = (const uint32_t*)&snapshot;
+    size_t length = 0;
+    buffer[length++] = TINKERIOT_STATS_VERSION;
+    buffer[length++] = TINKERIOT_STATS_FIELDS;
+    for (size_t i = 0; i < TINKERIOT_STATS_FIELDS; i++) {
+        uint32_t value = fields[i];
+        do {
+            if (length >= size) return 0;
+            uint8_t low = value & 0x7F;
+            value >>= 7;
+            buffer[length++] = value ? (low | 0x80) : low;
+        } while (value);
+    }
+    return length;
+}
+
+void TinkerIoTClass::resetStats() {
+    uint32_t* fields = (uint32_t*)&counters;
+    for (size_t i = 0; i < TINKERIOT_STATS_FIELDS; i++) {
+        __atomic_store_n(&fields[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+bool tinkerIoTImportStats(const uint8_t* data, size_t length, TinkerIoTStats& stats) {
+    memset(&stats, 0, sizeof(stats));
+    if (length < 2 || data[0] != TINKERIOT_STATS_VERSION) return false;
+    uint32_t* fields = (uint32_t*)&stats;
+    size_t position = 2;
+    for (uint8_t i = 0; i < data[1]; i++) {
+        uint32_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            if (position >= length || shift > 28) return false;
+            uint8_t byte = data[position++];
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        if (i < TINKERIOT_STATS_FIELDS) fields[i] = value;
+    }
+    return true;
+}
+
+// ===== LOGGING =====
+
+#if TINKERIOT_LOG_LEVEL > 0
+// The text of an event whose level is compiled out is left out too (as
+// nullptr); tinkerIoTFormatLog() prints such records by number.
+#define TINKERIOT_LOG_FMT(level, text) TINKERIOT_LOG_FMT_##level(text)
+#define TINKERIOT_LOG_FMT_E(text) text
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_WARN
+#define TINKERIOT_LOG_FMT_W(text) text
+#else
+#define TINKERIOT_LOG_FMT_W(text) nullptr
+#endif
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_INFO
+#define TINKERIOT_LOG_FMT_I(text) text
+#else
+#define TINKERIOT_LOG_FMT_I(text) nullptr
+#endif
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_DEBUG
+#define TINKERIOT_LOG_FMT_D(text) text
+#else
+#define TINKERIOT_LOG_FMT_D(text) nullptr
+#endif
+
+// Indexed by TinkerIoTLogEvent, E/W/I/D as the TINKERIOT_LOG* call that
+// records it. %d, %u and %c take the next argument.
+static const char* const logFormats[TINKERIOT_EV_COUNT] = {
+    TINKERIOT_LOG_FMT(W, "❌ Invalid pin number: %d"),
+    TINKERIOT_LOG_FMT(W, "❌ Cannot send C%d"),
+    TINKERIOT_LOG_FMT(D, "❌ Connection not ready (state:%d, failed:%c)"),
+    TINKERIOT_LOG_FMT(D, "⏳ Waiting for connection to stabilize before sending"),
+    TINKERIOT_LOG_FMT(E, "❌ Value too long to send on C%d"),
+    TINKERIOT_LOG_FMT(D, "📤 TinkerIoT.cloudWrite: C%d (%d bytes, ID %u)"),
+    TINKERIOT_LOG_FMT(D, "📦 Sending batch of %d values"),
+    TINKERIOT_LOG_FMT(D, "💾 Buffered C%d for replay (%d waiting)"),
+    TINKERIOT_LOG_FMT(I, "📊 Quota limit - one frame per %d ms"),
+    TINKERIOT_LOG_FMT(W, "⌛ No answer to frame %u"),
+    TINKERIOT_LOG_FMT(D, "📨 Received binary message (CMD %d, %d bytes)"),
+    TINKERIOT_LOG_FMT(D, "📨 Received text message (%d bytes)"),
+    TINKERIOT_LOG_FMT(W, "🤔 Unknown WebSocket event: %d"),
+    TINKERIOT_LOG_FMT(E, "❌ Invalid message length (%d bytes)"),
+    TINKERIOT_LOG_FMT(E, "❌ Body length %d exceeds payload (%d bytes)"),
+    TINKERIOT_LOG_FMT(D, "📋 CMD: %d, ID: %u, LEN: %d"),
+    TINKERIOT_LOG_FMT(D, "🏓 Ping received - sending response"),
+    TINKERIOT_LOG_FMT(D, "📬 Response: %d (ID %u)"),
+    TINKERIOT_LOG_FMT(W, "🤔 Unknown command: %d"),
+    TINKERIOT_LOG_FMT(D, "🔧 Hardware command: %c%c"),
+    TINKERIOT_LOG_FMT(D, "📥 Cloud write: C%d (%d bytes, tag %d)"),
+    TINKERIOT_LOG_FMT(D, "📤 Cloud read: C%d"),
+    TINKERIOT_LOG_FMT(D, "📥 Calling TINKERIOT_WRITE(C%d) handler"),
+    TINKERIOT_LOG_FMT(D, "🔧 No TINKERIOT_WRITE handler for pin C%d"),
+    TINKERIOT_LOG_FMT(E, "❌ Message too long for transmit buffer: %d"),
+    TINKERIOT_LOG_FMT(W, "❌ Not connected - cannot send message (CMD %d)"),
+    TINKERIOT_LOG_FMT(D, "📤 Sending TinkerIoT message: CMD=%d, ID=%u, LEN=%d"),
+    TINKERIOT_LOG_FMT(E, "❌ Network queue full - frame dropped (%d bytes)"),
+    TINKERIOT_LOG_FMT(E, "❌ Offline record dropped (C%d, type %d, %d bytes)"),
+    TINKERIOT_LOG_FMT(W, "✂️ Latency report on C%d cut from %d to %d characters"),
+};
+
+// "<ms>.<us> <level> <text>": no printf, so it costs the same on every board
+size_t tinkerIoTFormatLog(const TinkerIoTLogRecord& record, char* buffer, size_t size) {
+    if (size == 0) return 0;
+    size_t length = appendNumber(buffer, size, 0, record.micros / 1000, false);
+    if (length + 1 < size) buffer[length++] = '.';
+    uint32_t fraction = record.micros % 1000;
+    for (uint32_t scale = 100; scale > 0 && length + 1 < size; scale /= 10) {
+        buffer[length++] = '0' + fraction / scale % 10;
+    }
+    const char* level = " EWID";
+    if (length + 3 < size) {
+        buffer[length++] = ' ';
+        buffer[length++] = record.level <= TINKERIOT_LOG_DEBUG ? level[record.level] : '?';
+        buffer[length++] = ' ';
     }
 
-    // Automatic token validation - Check for login timeout
-    if (isConnected && !loginSent && !loginFailed) {
-        if (millis() - loginAttemptTime > loginTimeout) {
-            loginFailed = true;
-            #ifdef TINKERIOT_PRINT
-            TINKERIOT_PRINT.println();
-            TINKERIOT_PRINT.println("❌ TOKEN VALIDATION FAILED!");
-            TINKERIOT_PRINT.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
-            TINKERIOT_PRINT.println("🔑 ERROR: Invalid authentication token!");
-            TINKERIOT_PRINT.println("💡 Your token appears to be incorrect.");
-            TINKERIOT_PRINT.println();
-            TINKERIOT_PRINT.println("🔧 Please check:");
-            TINKERIOT_PRINT.println("   • Token spelling and format");
-            TINKERIOT_PRINT.println("   • Token is not expired");
-            TINKERIOT_PRINT.println("   • Device is properly registered");
-            TINKERIOT_PRINT.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
-            TINKERIOT_PRINT.println();
-            #endif
+    const char* format = record.event < TINKERIOT_EV_COUNT ? logFormats[record.event] : nullptr;
+    int32_t unknown[3] = { record.event, record.args[0], record.args[1] };
+    const int32_t* args = format ? record.args : unknown;
+    if (!format) format = "event %d: %d %d";  // Not in this build's table
+    int next = 0;
+    for (const char* c = format; *c && length + 1 < size; c++) {
+        if (c[0] != '%' || (c[1] != 'd' && c[1] != 'u' && c[1] != 'c') || next >= 3) {
+            buffer[length++] = *c;
+            continue;
         }
-    }
-    
-    // Send heartbeat periodically if connected
-    if (millis() - lastHeartbeat > heartbeatInterval) {
-        if (isConnected && loginSent) {
-            // Optional: You can add automatic heartbeat data here
-            // For example, send uptime or other system data
+        int32_t arg = args[next++];
+        c++;
+        if (*c == 'c') {
+            buffer[length++] = (char)arg;
+        } else if (*c == 'd' && arg < 0) {
+            length = appendNumber(buffer, size, length, 0u - (uint32_t)arg, true);
+        } else {
+            length = appendNumber(buffer, size, length, (uint32_t)arg, false);
         }
-        lastHeartbeat = millis();
     }
+    buffer[length] = 0;
+    return length;
 }
 
-// OPTIMIZED: Cloud write methods (Device → App) - REMOVED blocking delay
-void TinkerIoTClass::cloudWrite(int pin, String value) {
-    if (pin < 0 || pin >= 32) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("❌ Invalid pin number: ");
-        TINKERIOT_DATA_DEBUG.println(pin);        
-        #endif
-        return;
+// Any task: claim the next slot and fill it. The slot's sequence is 0
+// while the fields change, so a reader never takes a half-written record.
+void TinkerIoTClass::logEvent(uint8_t level, uint16_t event, int32_t a, int32_t b, int32_t c) {
+    if (level > logLevel) return;
+    uint32_t index = TINKERIOT_COUNT(logHead, 1);
+    TinkerIoTLogRecord& slot = logRing[index & (TINKERIOT_LOG_RECORDS - 1)];
+    __atomic_store_n(&slot.sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot.micros, (uint32_t)micros(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.event, event, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.level, level, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.args[0], a, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.args[1], b, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.args[2], c, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sequence, index + 1, __ATOMIC_RELEASE);
+}
+
+// Application task: the oldest complete record. False when the ring is
+// empty or its oldest slot is still being written.
+bool TinkerIoTClass::takeLog(TinkerIoTLogRecord& record) {
+    uint32_t head = __atomic_load_n(&logHead, __ATOMIC_RELAXED);
+    if (head - logTail > TINKERIOT_LOG_RECORDS) {
+        logLost += head - logTail - TINKERIOT_LOG_RECORDS;
+        logTail = head - TINKERIOT_LOG_RECORDS;
     }
-    
-    // Enhanced connection check - protect against sending during login phase
-    if (!isConnected || !loginSent || loginFailed) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("❌ Cannot send C");
-        TINKERIOT_DATA_DEBUG.print(pin);
-        TINKERIOT_DATA_DEBUG.print("=");
-        TINKERIOT_DATA_DEBUG.print(value);
-        TINKERIOT_DATA_DEBUG.print(" - connection not ready (connected:");
-        TINKERIOT_DATA_DEBUG.print(isConnected ? "Y" : "N");
-        TINKERIOT_DATA_DEBUG.print(", login:");
-        TINKERIOT_DATA_DEBUG.print(loginSent ? "Y" : "N");
-        TINKERIOT_DATA_DEBUG.print(", failed:");
-        TINKERIOT_DATA_DEBUG.print(loginFailed ? "Y" : "N");
-        TINKERIOT_DATA_DEBUG.println(")");
-        #endif
-        return;
+    while (logTail != head) {
+        TinkerIoTLogRecord& slot = logRing[logTail & (TINKERIOT_LOG_RECORDS - 1)];
+        uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+        if ((int32_t)(sequence - (logTail + 1)) < 0) return false;  // Claimed, not written yet
+        if (sequence == logTail + 1) {
+            record.micros = __atomic_load_n(&slot.micros, __ATOMIC_RELAXED);
+            record.event = __atomic_load_n(&slot.event, __ATOMIC_RELAXED);
+            record.level = __atomic_load_n(&slot.level, __ATOMIC_RELAXED);
+            record.reserved = 0;
+            for (int i = 0; i < 3; i++) record.args[i] = __atomic_load_n(&slot.args[i], __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) == sequence) {
+                record.sequence = sequence;
+                logTail++;
+                return true;
+            }
+        }
+        logLost++;  // Overwritten by a writer a lap ahead
+        logTail++;
     }
-    
-    // Add small grace period after login to ensure connection stability
-    if (loginSent && (millis() - loginAttemptTime) < 1000) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("⏳ Waiting for connection to stabilize before sending C");
-        TINKERIOT_DATA_DEBUG.print(pin);
-        TINKERIOT_DATA_DEBUG.print("=");
-        TINKERIOT_DATA_DEBUG.println(value);        
-        #endif
-        return;
+    return false;
+}
+
+uint16_t TinkerIoTClass::readLog(TinkerIoTLogRecord* records, uint16_t max) {
+    uint16_t taken = 0;
+    while (taken < max && takeLog(records[taken])) taken++;
+    return taken;
+}
+
+uint16_t TinkerIoTClass::printLog(Print& out, uint16_t max) {
+    return writeLog(out, max, false);
+}
+
+// whenRoom (run()): stop at the first line the output cannot take without
+// blocking. That record goes back to the ring; if writers lap it before
+// the next try it is counted in logLost like any other.
+uint16_t TinkerIoTClass::writeLog(Print& out, uint16_t max, bool whenRoom) {
+    uint16_t printed = 0;
+    TinkerIoTLogRecord record;
+    char line[96];
+    logStalled = false;
+    while (printed < max && takeLog(record)) {
+        size_t length = tinkerIoTFormatLog(record, line, sizeof(line));
+        if (whenRoom && out.availableForWrite() < (int)length + 2) {
+            logTail--;
+            logStalled = true;
+            break;
+        }
+        out.println(line);
+        printed++;
     }
-    
-    // CRITICAL SECTION: Protect cloudPins[] array access
-    TINKERIOT_LOCK(cloudPinsMutex);
-    cloudPins[pin] = value;
-    TINKERIOT_UNLOCK(cloudPinsMutex);
-
-    // Create command string with explicit null terminators
-    String command = "cw";
-    command += '\0';
-    command += String(pin);
-    command += '\0';
-    command += value;
-    
-    // Send to server
-    #ifdef TINKERIOT_DATA_DEBUG
-    TINKERIOT_DATA_DEBUG.print("📤 TinkerIoT.cloudWrite: C");
-    TINKERIOT_DATA_DEBUG.print(pin);
-    TINKERIOT_DATA_DEBUG.print(" = '");
-    TINKERIOT_DATA_DEBUG.print(value);
-    TINKERIOT_DATA_DEBUG.println("'");    
-    #endif
-    sendHardwareMessage(0, command);
+    return printed;
+}
+#endif
 
-    // PRIORITY FIX: Yield CPU to allow incoming widget commands to be processed
-    // This prevents sensor sends from blocking button commands
-    yield();
+bool TinkerIoTClass::hasDirtyPins() {
+    for (int word = 0; word * 32 < pinCount; word++) {
+        if (dirtyPins[word]) return true;
+    }
+    return false;
 }
 
-void TinkerIoTClass::cloudWrite(int pin, int value) {
-    cloudWrite(pin, String(value));
+// Internal batch for flush() and the heartbeat; commitBatch() sends it
+void TinkerIoTClass::openBatch() {
+    commitBatch();
+    batchOpen = true;
+    batchCount = 0;
 }
 
-void TinkerIoTClass::cloudWrite(int pin, float value) {
-    cloudWrite(pin, String(value, 2));
+// Append the stored values of a set of pins (bit n = C(firstPin + n)) to
+// the open batch. Returns the pins left out because the send window closed.
+uint32_t TinkerIoTClass::sendPins(int firstPin, uint32_t pins) {
+    for (int pin = firstPin; pins != 0; pin++, pins >>= 1) {
+        if (pins & 1) {
+            if (!sendWindowOpen()) return pins << (pin - firstPin);
+            size_t valueStart;
+            appendPinValue(pin, StoredValue{pin}, valueStart);
+        }
+    }
+    return 0;
 }
 
-void TinkerIoTClass::cloudWrite(int pin, double value) {
-    cloudWrite(pin, String(value, 2));
+// Send the stored value of a pin as a cw frame (empty for unknown pins)
+void TinkerIoTClass::sendStoredPin(int pin, uint16_t msg_id) {
+    txFrame.begin(HARDWARE, msg_id);
+    txFrame.putCloudWriteHeader(pin);
+    if (pin >= 0 && pin < pinCount) {
+        putValue(pin, StoredValue{pin});
+    }
+    if (txFrame.finish() == 0) return;
+    sendFrame(txFrame);
 }
 
 // Register write handler (internal use) - Enhanced with better debugging
-void TinkerIoTClass::_registerWriteHandler(int pin, TinkerIoTWriteHandler handler) {
-    if (pin >= 0 && pin < 32) {
+void TinkerIoTClass::_registerWriteHandler(int pin, TinkerIoTHandler handler) {
+    if (pin >= 0 && pin < pinCount) {
         writeHandlers[pin] = handler;
         #ifdef TINKERIOT_PRINT
         TINKERIOT_PRINT.print("✅ Handler registered for C");
@@ -259,13 +1898,8 @@ void TinkerIoTClass::_registerWriteHandler(int pin, TinkerIoTWriteHandler handle
     }
 }
 
-// WiFi connection
+// WiFi connection - starts association only; runConnection() waits for it
 void TinkerIoTClass::connectToWiFi() {
-    #if defined(ARDUINO_SAMD_NANO_33_IOT) || defined(ARDUINO_SAMD_MKRWIFI1010)
-    while (!TINKERIOT_PRINT) {
-        3; // Wait for serial port
-      }
-    #endif
     #ifdef TINKERIOT_PRINT
     TINKERIOT_PRINT.print("📶 Connecting to WiFi: ");
     TINKERIOT_PRINT.println(wifi_ssid);
@@ -278,25 +1912,126 @@ void TinkerIoTClass::connectToWiFi() {
         #ifdef TINKERIOT_PRINT
         TINKERIOT_PRINT.println("❌ WiFi module not found!");
         #endif
-        while (true); // Don't continue
+        return; // Stay idle - the sketch keeps running
     }
     #endif
     
     WiFi.begin(wifi_ssid.c_str(), wifi_password.c_str());
-    
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
+    wifiBeginAt = millis();
+    if (connState != TINKERIOT_WIFI_CONNECTING) setState(TINKERIOT_WIFI_CONNECTING);
+}
+
+// Enter a connection phase and record how long the previous one took
+void TinkerIoTClass::setState(TinkerIoTState next) {
+    unsigned long now = millis();
+    unsigned long elapsed = now - phaseStart;
+
+    if (linkState() == TINKERIOT_WIFI_CONNECTING && next == TINKERIOT_WS_CONNECTING) {
+        connectTimes.wifi = elapsed;
+    } else if (linkState() == TINKERIOT_WS_CONNECTING && next == TINKERIOT_LOGGING_IN) {
+        connectTimes.webSocket = elapsed;
+    } else if (linkState() == TINKERIOT_LOGGING_IN && next == TINKERIOT_READY) {
+        connectTimes.login = elapsed;
+        connectTimes.total = now - attemptStart;
+        connectTimes.connections++;
         #ifdef TINKERIOT_PRINT
-        TINKERIOT_PRINT.print(".");
+        TINKERIOT_PRINT.print("⏱️ Connected in ");
+        TINKERIOT_PRINT.print(connectTimes.total);
+        TINKERIOT_PRINT.print(" ms (WiFi ");
+        TINKERIOT_PRINT.print(connectTimes.wifi);
+        TINKERIOT_PRINT.print(" ms, WebSocket ");
+        TINKERIOT_PRINT.print(connectTimes.webSocket);
+        TINKERIOT_PRINT.print(" ms, login ");
+        TINKERIOT_PRINT.print(connectTimes.login);
+        TINKERIOT_PRINT.println(" ms)");
         #endif
     }
-    
-    #ifdef TINKERIOT_PRINT
-    TINKERIOT_PRINT.println();
-    TINKERIOT_PRINT.println("✅ WiFi connected!");
-    TINKERIOT_PRINT.print("📍 IP address: ");
-    TINKERIOT_PRINT.println(WiFi.localIP());
-    #endif
+
+    // A new attempt starts when we fall back to waiting for WiFi or the socket
+    if (next == TINKERIOT_WIFI_CONNECTING) {
+        attemptStart = now;
+    } else if (next == TINKERIOT_WS_CONNECTING && linkState() != TINKERIOT_WIFI_CONNECTING) {
+        attemptStart = now;
+        connectTimes.wifi = 0;
+    }
+
+    phaseStart = now;
+    __atomic_store_n(&connState, next, __ATOMIC_RELEASE);
+}
+
+// One step of the connection state machine (called from run())
+void TinkerIoTClass::runConnection() {
+    unsigned long now = millis();
+
+    switch (linkState()) {
+        case TINKERIOT_WIFI_CONNECTING:
+            if (WiFi.status() == WL_CONNECTED) {
+                #ifdef TINKERIOT_PRINT
+                TINKERIOT_PRINT.println();
+                TINKERIOT_PRINT.println("✅ WiFi connected!");
+                TINKERIOT_PRINT.print("📍 IP address: ");
+                TINKERIOT_PRINT.println(WiFi.localIP());
+                #endif
+                lastWiFiCheck = now;
+                setState(TINKERIOT_WS_CONNECTING);
+                if (!webSocketStarted) {
+                    setupWebSocket();
+                    webSocketStarted = true;
+                }
+            } else if (now - phaseStart >= TINKERIOT_WIFI_RETRY_MS && now - wifiBeginAt >= TINKERIOT_WIFI_RETRY_MS) {
+                // Still no WiFi (or lost it): start the association again
+                connectToWiFi();
+            } else {
+                #ifdef TINKERIOT_PRINT
+                if (now - lastProgressDot >= 500) {
+                    lastProgressDot = now;
+                    TINKERIOT_PRINT.print(".");
+                }
+                #endif
+            }
+            return;
+
+        case TINKERIOT_LOGGING_IN:
+            if (!loginPending && !loginFailed) {
+                if (now - phaseStart >= loginDelay) sendLogin();
+            } else if (loginPending && now - loginTime() > loginTimeout) {
+                // Automatic token validation - no answer to LOGIN
+                loginPending = false;
+                loginFailed = true;
+                TINKERIOT_COUNT(counters.loginFailures, 1);
+                #ifdef TINKERIOT_PRINT
+                TINKERIOT_PRINT.println();
+                TINKERIOT_PRINT.println("❌ TOKEN VALIDATION FAILED!");
+                TINKERIOT_PRINT.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
+                TINKERIOT_PRINT.println("🔑 ERROR: Invalid authentication token!");
+                TINKERIOT_PRINT.println("💡 Your token appears to be incorrect.");
+                TINKERIOT_PRINT.println();
+                TINKERIOT_PRINT.println("🔧 Please check:");
+                TINKERIOT_PRINT.println("   • Token spelling and format");
+                TINKERIOT_PRINT.println("   • Token is not expired");
+                TINKERIOT_PRINT.println("   • Device is properly registered");
+                TINKERIOT_PRINT.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
+                TINKERIOT_PRINT.println();
+                #endif
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    // WiFi lost: drop the socket and wait for WiFi again. Polled twice a
+    // second - on WiFiNINA boards status() is an SPI round trip.
+    if (linkState() > TINKERIOT_WIFI_CONNECTING && now - lastWiFiCheck >= 500) {
+        lastWiFiCheck = now;
+        if (WiFi.status() != WL_CONNECTED) {
+            #ifdef TINKERIOT_PRINT
+            TINKERIOT_PRINT.println("📶 WiFi lost - reconnecting...");
+            #endif
+            setState(TINKERIOT_WIFI_CONNECTING);
+            webSocket.disconnect();
+        }
+    }
 }
 
 // WebSocket setup
@@ -331,6 +2066,11 @@ void TinkerIoTClass::webSocketEventStatic(WStype_t type, uint8_t * payload, size
 
 // WebSocket event handler
 void TinkerIoTClass::webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
+    socketEvents++;  // Tells drainSocket() that loop() made progress
+    #if defined(ESP8266)
+    sampleHeap();  // No low-water mark in the SDK: sample where the socket allocates
+    #endif
+    
     switch(type) {
         case WStype_DISCONNECTED:
             // Track connection failures for token detection
@@ -372,8 +2112,10 @@ void TinkerIoTClass::webSocketEvent(WStype_t type, uint8_t * payload, size_t len
             }
             // Don't show repeated "WebSocket Disconnected" after token error reported
             
-            isConnected = false;
-            loginSent = false;
+            loginPending = false;
+            if (linkState() > TINKERIOT_WS_CONNECTING) {
+                setState(TINKERIOT_WS_CONNECTING);
+            }
             break;
             
         case WStype_CONNECTED:
@@ -381,27 +2123,36 @@ void TinkerIoTClass::webSocketEvent(WStype_t type, uint8_t * payload, size_t len
             TINKERIOT_PRINT.print("✅ WebSocket Connected to: ");
             TINKERIOT_PRINT.println((char*)payload);            
             #endif
-            isConnected = true;
             loginFailed = false;
+            loginPending = false;
             connectionFailureCount = 0;  // Reset failure count on successful connection
-            delay(1000);
-            sendLogin();
+            if (sessionSeen) TINKERIOT_COUNT(counters.reconnects, 1);
+            sessionSeen = true;
+            setState(TINKERIOT_LOGGING_IN);
+            if (loginDelay == 0) {
+                sendLogin();  // Otherwise runConnection() sends it once loginDelay passed
+            }
             break;
             
         case WStype_BIN:
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.print("📨 Received binary message (");
-            TINKERIOT_DATA_DEBUG.print(length);
-            TINKERIOT_DATA_DEBUG.println(" bytes)");            
+            TINKERIOT_LOGD(TINKERIOT_EV_FRAME_IN, length > 0 ? payload[0] : -1, length);
+            if (length > 0) countFrame(counters.in, payload, length);
+            #ifdef TINKERIOT_HAS_NETWORK_TASK
+            if (networkTaskActive && length >= 5 &&
+                (payload[0] == HARDWARE || (payload[0] == RESPONSE && !(loginPending && payload[1] == 0 && payload[2] <= 1)))) {
+                // Commands run their handlers, and answers settle the
+                // send window, on the application task
+                inboundRing.push(payload, length, true, micros());
+                notify();
+                break;
+            }
             #endif
+            if (payload[0] == HARDWARE) rxMicros = micros();  // Handled right away, on this task
             handleTinkerIoTMessage(payload, length);
             break;
             
         case WStype_TEXT:
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.print("📨 Received text message: ");
-            TINKERIOT_DATA_DEBUG.println((char*)payload);
-            #endif
+            TINKERIOT_LOGD(TINKERIOT_EV_TEXT_IN, length);
             break;
             
         case WStype_ERROR:
@@ -412,75 +2163,79 @@ void TinkerIoTClass::webSocketEvent(WStype_t type, uint8_t * payload, size_t len
             break;
             
         default:
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.print("🤔 Unknown WebSocket event: ");
-            TINKERIOT_DATA_DEBUG.println(type);            
-            #endif
+            TINKERIOT_LOGW(TINKERIOT_EV_UNKNOWN_WS_EVENT, type);
             break;
     }
 }
 
 // Handle TinkerIoT protocol messages
-void TinkerIoTClass::handleTinkerIoTMessage(uint8_t* data, size_t length) {
+void TinkerIoTClass::handleTinkerIoTMessage(uint8_t* data, size_t length, bool queued) {
     if (length < 5) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.println("❌ Invalid message length");
-        #endif
+        TINKERIOT_LOGE(TINKERIOT_EV_SHORT_FRAME, length);
         return;
     }
     
     uint8_t command = data[0];
     uint16_t msg_id = (data[1] << 8) | data[2];
     uint16_t body_length = (data[3] << 8) | data[4];
+
+    // The header must not claim more body than was actually received
+    if (body_length > length - 5) {
+        TINKERIOT_LOGE(TINKERIOT_EV_BODY_OVERRUN, body_length, length);
+        return;
+    }
+
+    // Fields are parsed in place, so the body must be NUL-terminated.
+    // arduinoWebSockets always terminates the payload at data[length];
+    // terminate here too when the frame carries trailing bytes.
+    if (5 + (size_t)body_length < length) {
+        data[5 + body_length] = 0;
+    }
     
-    #ifdef TINKERIOT_DATA_DEBUG
-    TINKERIOT_DATA_DEBUG.print("📋 CMD: ");
-    TINKERIOT_DATA_DEBUG.print(command);
-    TINKERIOT_DATA_DEBUG.print(", ID: ");
-    TINKERIOT_DATA_DEBUG.print(msg_id);
-    TINKERIOT_DATA_DEBUG.print(", LEN: ");
-    TINKERIOT_DATA_DEBUG.println(body_length);    
-    #endif
+    TINKERIOT_LOGD(TINKERIOT_EV_COMMAND, command, msg_id, body_length);
     
     switch (command) {
         case PING:
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.println("🏓 Ping received - sending response");
-            #endif
+            TINKERIOT_LOGD(TINKERIOT_EV_PING);
             sendResponse(msg_id, SUCCESS);
             break;
             
         case HARDWARE:
-            if (length > 5) {
+            if (body_length > 0) {
                 handleHardwareCommand(msg_id, data + 5, body_length);
             }
             break;
             
         case RESPONSE:
-            if (length > 5) {
+            if (body_length > 0) {
                 uint8_t status = data[5];
                 
-                #ifdef TINKERIOT_DATA_DEBUG
-                TINKERIOT_DATA_DEBUG.print("📬 Response: ");
-                TINKERIOT_DATA_DEBUG.print(status == SUCCESS ? "SUCCESS" : "ERROR");
-                TINKERIOT_DATA_DEBUG.print(" (");
-                TINKERIOT_DATA_DEBUG.print(status);
-                TINKERIOT_DATA_DEBUG.println(")");                    
-                #endif
+                TINKERIOT_LOGD(TINKERIOT_EV_RESPONSE, status, msg_id);
                 
-                // Handle login response specifically
-                if (!loginSent && !loginFailed) {
+                // Handle login response specifically (LOGIN goes out as id 1;
+                // the other frames we number start at 2, see nextMsgId()).
+                // A queued frame is never it: webSocketEvent() kept that one.
+                if (queued || !loginPending || msg_id > 1) {
+                    handleAck(msg_id, status);
+                } else {
+                    loginPending = false;
                     if (status == SUCCESS) {
-                        loginSent = true;
-                        loginAttemptTime = millis(); // Record successful login time
+                        __atomic_store_n(&loginAttemptTime, millis(), __ATOMIC_RELAXED);  // Record successful login time
+                        // Servers that know the features we asked for append the accepted mask
+                        bool binary = binaryRequested && body_length > 1 &&
+                                      (data[6] & TINKERIOT_FEATURE_BINARY_VALUES);
+                        __atomic_store_n(&binaryValues, binary, __ATOMIC_RELAXED);
                         #ifdef TINKERIOT_PRINT
                         TINKERIOT_PRINT.println();
                         TINKERIOT_PRINT.println("✅ TOKEN VALIDATED SUCCESSFULLY!");
                         TINKERIOT_PRINT.println("🎉 Authentication complete - Ready to use!");
+                        if (binaryActive()) TINKERIOT_PRINT.println("🔢 Binary values enabled");
                         TINKERIOT_PRINT.println();
                         #endif
+                        setState(TINKERIOT_READY);
                     } else {
                         loginFailed = true;
+                        TINKERIOT_COUNT(counters.loginFailures, 1);
                         #ifdef TINKERIOT_PRINT
                         TINKERIOT_PRINT.println();
                         TINKERIOT_PRINT.println("❌ TOKEN VALIDATION FAILED!");
@@ -529,119 +2284,267 @@ void TinkerIoTClass::handleTinkerIoTMessage(uint8_t* data, size_t length) {
             break;
             
         default:
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.print("🤔 Unknown command: ");
-            TINKERIOT_DATA_DEBUG.println(command);            
-            #endif
+            TINKERIOT_LOGW(TINKERIOT_EV_UNKNOWN_COMMAND, command);
             break;
     }
 }
 
-// Handle hardware commands
+// Handle hardware commands - fields are views into body, nothing is copied.
+// A body may carry several tuples (cw\0<pin>\0<value>\0cr\0<pin>...);
+// written pins are acknowledged with one RESPONSE per frame, after one
+// HARDWARE frame with their echoes and whatever the handlers wrote.
 void TinkerIoTClass::handleHardwareCommand(uint16_t msg_id, uint8_t* body, uint16_t length) {
-    String command = "";
-    for (int i = 0; i < length; i++) {
-        command += (char)body[i];
-    }
+    TinkerIoTFrameReader reader(body, length);
+    TinkerIoTView cmdType = {nullptr, 0};
+    TinkerIoTView pinStr = {nullptr, 0};
+    TinkerIoTView value = {nullptr, 0};
+    uint8_t tag = 0;
+    bool acknowledge = false;
     
-    #ifdef TINKERIOT_DATA_DEBUG
-    TINKERIOT_DATA_DEBUG.print("🔧 Hardware command: ");
-    TINKERIOT_DATA_DEBUG.println(command);    
-    #endif
-    
-    int firstNull = command.indexOf('\0');
-    int secondNull = command.indexOf('\0', firstNull + 1);
-    
-    if (firstNull == -1) return;
-    
-    String cmdType = command.substring(0, firstNull);
-    String pinStr = command.substring(firstNull + 1, secondNull > 0 ? secondNull : command.length());
-    
-    int pin = pinStr.toInt();
-    
-    if (cmdType == "cw") {
-        // Cloud write - server writing to device
-        if (secondNull > 0) {
-            String value = command.substring(secondNull + 1);
-            #ifdef TINKERIOT_DATA_DEBUG
-            TINKERIOT_DATA_DEBUG.print("📥 Cloud write: C");
-            TINKERIOT_DATA_DEBUG.print(pin);
-            TINKERIOT_DATA_DEBUG.print(" = ");
-            TINKERIOT_DATA_DEBUG.println(value);            
-            #endif
-            
-            if (pin >= 0 && pin < 32) {
-                // CRITICAL SECTION: Protect cloudPins[] array access
-                TINKERIOT_LOCK(cloudPinsMutex);
-                cloudPins[pin] = value;
-                TINKERIOT_UNLOCK(cloudPinsMutex);
-                cloudRead(pin, value);
+    openBatch();
+    while (reader.next(cmdType)) {
+        TINKERIOT_LOGD(TINKERIOT_EV_HARDWARE_COMMAND, cmdType.length > 0 ? cmdType.data[0] : ' ',
+                       cmdType.length > 1 ? cmdType.data[1] : ' ');
+        
+        if (!reader.next(pinStr)) break;
+        
+        long pin = -1;
+        if (!pinStr.toLong(pin)) pin = -1;
+        
+        if (cmdType.equals("cw")) {
+            // Cloud write - server writing to device
+            acknowledge = true;
+            if (reader.nextValue(value, tag, binaryActive())) {
+                // value.data is NUL-terminated (raw payloads too): either by the
+                // next separator or by the terminator handleTinkerIoTMessage
+                // guarantees after the body. Tagged numbers are decoded here and
+                // reach typed handlers without any text in between.
+                TINKERIOT_LOGD(TINKERIOT_EV_CLOUD_WRITE_IN, pin, value.length, tag);
+                
+                if (pin >= 0 && pin < pinCount) {
+                    if (tag == TINKERIOT_TAG_INT32) {
+                        int number = (int32_t)value.toWord();
+                        storePin(pin, number);
+                        cloudRead(pin, number, 0);
+                    } else if (tag == TINKERIOT_TAG_FLOAT32) {
+                        uint32_t bits = value.toWord();
+                        float number;
+                        memcpy(&number, &bits, sizeof(number));
+                        storePin(pin, (double)number);
+                        cloudRead(pin, number, 0);
+                    } else {
+                        storePin(pin, TINKERIOT_VALUE_TEXT, value.data, value.length);
+                        cloudRead(pin, value.data, value.length);
+                    }
+                }
             }
+
+        } else if (cmdType.equals("cr")) {
+            // Cloud read - server reading from device. The stored value is
+            // copied straight into the response frame.
+            TINKERIOT_LOGD(TINKERIOT_EV_CLOUD_READ_IN, pin);
+            
+            commitBatch();  // The reply takes the transmit buffer
+            sendStoredPin(pin, msg_id);
+            openBatch();
+
+        } else {
+            break;  // Unknown command - the rest of the body cannot be framed
         }
+    }
+    commitBatch();
+
+    if (acknowledge) {
         sendResponse(msg_id, SUCCESS);
+    }
+}
 
-    } else if (cmdType == "cr") {
-        // Cloud read - server reading from device
-        String value = "";
-        if (pin >= 0 && pin < 32) {
-            // CRITICAL SECTION: Protect cloudPins[] array access
-            TINKERIOT_LOCK(cloudPinsMutex);
-            value = cloudPins[pin];
-            TINKERIOT_UNLOCK(cloudPinsMutex);
+// A stored value as a number, if it is one (text as the handlers parse it)
+static bool pinNumber(const TinkerIoTPinValue& value, double& out) {
+    switch (value.type) {
+        case TINKERIOT_VALUE_INT:
+            out = value.asInt;
+            return true;
+        case TINKERIOT_VALUE_FLOAT:
+            out = value.asFloat;
+            return true;
+        case TINKERIOT_VALUE_TEXT: {
+            TinkerIoTView text = { value.text, value.length };
+            long integer;
+            float number;
+            if (text.toLong(integer)) {
+                out = integer;
+            } else if (text.toFloat(number)) {
+                out = number;
+            } else {
+                return false;
+            }
+            return true;
         }
-        
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("📤 Cloud read: C");
-        TINKERIOT_DATA_DEBUG.print(pin);
-        TINKERIOT_DATA_DEBUG.print(" = ");
-        TINKERIOT_DATA_DEBUG.println(value);        
-        #endif
-        
-        String response = "cw\0" + String(pin) + "\0" + value;
-        sendHardwareMessage(msg_id, response);
+        default:
+            return false;
     }
 }
 
-// Handle cloud read (App → Device) - Enhanced with better debugging
-void TinkerIoTClass::cloudRead(int pin, String value) {
-    if (pin >= 0 && pin < 32 && writeHandlers[pin] != nullptr) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("📥 Calling TINKERIOT_WRITE(C");
-        TINKERIOT_DATA_DEBUG.print(pin);
-        TINKERIOT_DATA_DEBUG.print(") handler with value: ");
-        TINKERIOT_DATA_DEBUG.println(value);        
-        #endif
-        
-        // Update global param object
-        param.setValue(value);
-        
-        // Call the registered handler function
-        writeHandlers[pin](value);
+// Whether a handler's write repeats the value that came in: "50" as text
+// and 50 as an int are the same value
+static bool samePinValue(const TinkerIoTPinValue& a, const TinkerIoTPinValue& b) {
+    double x, y;
+    if (pinNumber(a, x) && pinNumber(b, y)) return x == y;
+    return a.type == b.type && a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+// Handle cloud read (App → Device) - Enhanced with better debugging.
+// 'value' is text (with its length) or a decoded binary int/float.
+template <typename T>
+void TinkerIoTClass::cloudRead(int pin, T value, size_t length) {
+    if (pin >= 0 && pin < pinCount && writeHandlers[pin].kind != TinkerIoTHandler::NONE) {
+        TINKERIOT_LOGD(TINKERIOT_EV_HANDLER_CALL, pin);
+
+        // CHANGED and COALESCED take the handler's own write to the pin as
+        // the echo; CHANGED compares it with the value that came in
+        uint8_t echo = pinReports[pin].echo;
+        TinkerIoTPinValue received;
+        if (echo == TINKERIOT_ECHO_CHANGED) {
+            loadPin(pin, received);  // As handleHardwareCommand stored it
+        }
+        if (echo == TINKERIOT_ECHO_CHANGED || echo == TINKERIOT_ECHO_COALESCED) {
+            echoCapturePin = pin;
+            echoCaptured = false;
+        }
         
-        // Echo the pin to send the value to dashboard
-        cloudWrite(pin, value);
+        // Call the registered handler function, timed
+        uint32_t start = micros();
+        latency.dispatch.add(start - rxMicros);
+        callHandler(pin, value, length);
+        uint32_t spent = micros() - start;
+        latency.handler.add(spent);
+        TinkerIoTHandlerTiming& timing = handlerTimings[pin];
+        timing.calls++;
+        timing.totalMicros += spent;
+        if (spent > timing.maxMicros) timing.maxMicros = spent;
+        TINKERIOT_COUNT(counters.handlerCalls, 1);
+        if (spent > counters.handlerMaxMicros) counters.handlerMaxMicros = spent;  // Application task only
+        echoCapturePin = -1;
+
+        switch (echo) {
+            case TINKERIOT_ECHO_NONE:
+                break;  // The RESPONSE acknowledges the write
+
+            case TINKERIOT_ECHO_CHANGED: {
+                if (!echoCaptured) break;
+                TinkerIoTPinValue written;
+                loadPin(pin, written);
+                if (samePinValue(received, written)) break;
+                if (!batchOpen) openBatch();  // The handler sent the inbound frame's batch
+                if (!readyToSend() || sendPins(pin, 1)) {
+                    markEcho(pin);  // Goes out with the coalesced echoes instead
+                }
+                break;
+            }
+
+            case TINKERIOT_ECHO_COALESCED:
+                markEcho(pin);
+                break;
 
-        // Don't store control pin values for pins 0-10 to prevent echo
-        if (pin > 10) {
-            // CRITICAL SECTION: Protect cloudPins[] array access
-            TINKERIOT_LOCK(cloudPinsMutex);
-            cloudPins[pin] = value;
-            TINKERIOT_UNLOCK(cloudPinsMutex);
+            default:
+                // Echo the pin to send the value to dashboard, in the encoding it came in
+                writePin(pin, value);
+                break;
         }
     } else {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.print("🔧 No TINKERIOT_WRITE handler for pin C");
-        TINKERIOT_DATA_DEBUG.print(pin);
-        TINKERIOT_DATA_DEBUG.print(": ");
-        TINKERIOT_DATA_DEBUG.println(value);
-        #endif
+        TINKERIOT_LOGD(TINKERIOT_EV_NO_HANDLER, pin);
+
+        if (pin >= 0 && pin < pinCount) {
+            storePin(pin, value);
+        }
+    }
+}
+
+// Parse the value once for the handler's type. Parsing follows String:
+// toInt()/toFloat() for numbers, param.asBool() for booleans. Plain
+// decimals take the TinkerIoTView fast paths; anything else (exponents,
+// trailing text) falls back to the C library. Binary values arrive already
+// decoded and are only formatted for text handlers.
+void TinkerIoTClass::callHandler(int pin, const char* value, size_t length) {
+    const TinkerIoTHandler& handler = writeHandlers[pin];
+    TinkerIoTView text = { value, (uint16_t)length };
+    switch (handler.kind) {
+        case TinkerIoTHandler::STRING:
+            param.setValue(value);  // Update global param object
+            handler.asString(String(value));
+            break;
+        case TinkerIoTHandler::INT: {
+            long number;
+            if (!text.toLong(number)) number = strtol(value, nullptr, 10);
+            handler.asInt((int)number);
+            break;
+        }
+        case TinkerIoTHandler::FLOAT: {
+            float number;
+            if (!text.toFloat(number)) number = (float)strtod(value, nullptr);
+            handler.asFloat(number);
+            break;
+        }
+        case TinkerIoTHandler::BOOL:
+            handler.asBool(strcmp(value, "1") == 0 || strcasecmp(value, "true") == 0 || strcasecmp(value, "on") == 0);
+            break;
+        case TinkerIoTHandler::RAW:
+            handler.asRaw(value, length);
+            break;
+        default:
+            break;
+    }
+}
+
+void TinkerIoTClass::callHandler(int pin, int value, size_t length) {
+    const TinkerIoTHandler& handler = writeHandlers[pin];
+    switch (handler.kind) {
+        case TinkerIoTHandler::INT:
+            handler.asInt(value);
+            break;
+        case TinkerIoTHandler::FLOAT:
+            handler.asFloat((float)value);
+            break;
+        case TinkerIoTHandler::BOOL:
+            handler.asBool(value == 1);
+            break;
+        case TinkerIoTHandler::STRING:
+        case TinkerIoTHandler::RAW: {
+            uint8_t buffer[16];
+            TinkerIoTFrameWriter text(buffer, sizeof(buffer));
+            text.putInt(value);
+            callHandler(pin, text.textAt(0), text.length());
+            break;
+        }
+        default:
+            break;
+    }
+}
 
-        if (pin >= 0 && pin < 32) {
-            // CRITICAL SECTION: Protect cloudPins[] array access
-            TINKERIOT_LOCK(cloudPinsMutex);
-            cloudPins[pin] = value;
-            TINKERIOT_UNLOCK(cloudPinsMutex);
+void TinkerIoTClass::callHandler(int pin, float value, size_t length) {
+    const TinkerIoTHandler& handler = writeHandlers[pin];
+    switch (handler.kind) {
+        case TinkerIoTHandler::INT:
+            handler.asInt((int)value);
+            break;
+        case TinkerIoTHandler::FLOAT:
+            handler.asFloat(value);
+            break;
+        case TinkerIoTHandler::BOOL:
+            handler.asBool(value == 1.0f);
+            break;
+        case TinkerIoTHandler::STRING:
+        case TinkerIoTHandler::RAW: {
+            // As writePin() would send it: the pin's setPrecision() digits
+            uint8_t buffer[40];
+            TinkerIoTFrameWriter text(buffer, sizeof(buffer));
+            text.putFixed(value, pinReports[pin].decimals);
+            callHandler(pin, text.textAt(0), text.length());
+            break;
         }
+        default:
+            break;
     }
 }
 
@@ -651,8 +2554,17 @@ void TinkerIoTClass::sendLogin() {
     TINKERIOT_PRINT.println("🔐 Sending login message...");
     #endif
     
-    loginAttemptTime = millis();  // Record login attempt time
-    sendTinkerIoTMessage(LOGIN, 1, "");
+    __atomic_store_n(&loginAttemptTime, millis(), __ATOMIC_RELAXED);  // Record login attempt time
+    loginPending = true;
+    __atomic_store_n(&binaryValues, false, __ATOMIC_RELAXED);         // Negotiated again by every login
+    // Built on the stack: the network task must not touch txBuffer
+    uint8_t frame[9] = { LOGIN, 0, 1, 0, 0, 'f', 'e', 0, '0' + TINKERIOT_FEATURE_BINARY_VALUES };
+    size_t length = 5;
+    if (binaryRequested) {
+        frame[4] = 4;             // "fe\0<mask>"
+        length = sizeof(frame);
+    }
+    transmit(frame, length);
 }
 
 // Send hardware message
@@ -670,40 +2582,357 @@ void TinkerIoTClass::sendResponse(uint16_t msg_id, uint8_t status) {
     responseData[4] = 1;
     responseData[5] = status;
     
-    webSocket.sendBIN(responseData, 6);
+    transmit(responseData, 6);
+}
+
+// Send TinkerIoT message - encoded into txBuffer, no heap allocation
+void TinkerIoTClass::sendTinkerIoTMessage(uint8_t command, uint16_t msg_id, const uint8_t* body, uint16_t length) {
+    commitBatch();
+    TinkerIoTFrameWriter& frame = txFrame;
+    frame.begin(command, msg_id);
+    frame.putText((const char*)body, length);
+    if (frame.finish() == 0) {
+        TINKERIOT_LOGE(TINKERIOT_EV_MESSAGE_TOO_LONG, length);
+        return;
+    }
+    sendFrame(frame);
 }
 
-// Send TinkerIoT message
 void TinkerIoTClass::sendTinkerIoTMessage(uint8_t command, uint16_t msg_id, String body) {
-    if (!isConnected) {
-        #ifdef TINKERIOT_DATA_DEBUG
-        TINKERIOT_DATA_DEBUG.println("❌ Not connected - cannot send message");
-        #endif
+    sendTinkerIoTMessage(command, msg_id, (const uint8_t*)body.c_str(), body.length());
+}
+
+// Send an encoded frame
+void TinkerIoTClass::sendFrame(TinkerIoTFrameWriter& frame) {
+    if (linkState() < TINKERIOT_LOGGING_IN) {
+        TINKERIOT_LOGW(TINKERIOT_EV_SEND_NOT_CONNECTED, frame.data()[0]);
         return;
     }
     
-    uint16_t bodyLength = body.length();
-    uint8_t* message = new uint8_t[5 + bodyLength];
-    
-    message[0] = command;
-    message[1] = (msg_id >> 8) & 0xFF;
-    message[2] = msg_id & 0xFF;
-    message[3] = (bodyLength >> 8) & 0xFF;
-    message[4] = bodyLength & 0xFF;
+    TINKERIOT_LOGD(TINKERIOT_EV_SEND, frame.data()[0], frame.msgId(), frame.length() - TinkerIoTFrameWriter::HEADER_SIZE);
     
-    for (int i = 0; i < bodyLength; i++) {
-        message[5 + i] = body[i];
+    transmit(frame.data(), frame.length());
+}
+
+// Hand a frame to the socket, or to the network task that owns it
+void TinkerIoTClass::transmit(uint8_t* data, size_t length) {
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    if (networkTaskActive && !onNetworkTask()) {
+        // A full queue is waited on briefly rather than dropped
+        unsigned long start = millis();
+        while (!outboundRing.push(data, length)) {
+            if (length > netFrameSize || millis() - start >= TINKERIOT_NET_SEND_WAIT_MS) {
+                outboundRing.countDrop();
+                TINKERIOT_LOGE(TINKERIOT_EV_QUEUE_FULL, length);
+                return;
+            }
+            wakeNetworkTask();
+            delay(1);
+        }
+        wakeNetworkTask();
+        return;
     }
-    
-    #ifdef TINKERIOT_DATA_DEBUG
-    TINKERIOT_DATA_DEBUG.print("📤 Sending TinkerIoT message: CMD=");
-    TINKERIOT_DATA_DEBUG.print(command);
-    TINKERIOT_DATA_DEBUG.print(", ID=");
-    TINKERIOT_DATA_DEBUG.print(msg_id);
-    TINKERIOT_DATA_DEBUG.print(", LEN=");
-    TINKERIOT_DATA_DEBUG.println(bodyLength);    
     #endif
-    
-    webSocket.sendBIN(message, 5 + bodyLength);
-    delete[] message;
+    countFrame(counters.out, data, length);
+    webSocket.sendBIN(data, length);
+}
+
+// ===== TIMER =====
+
+TinkerIoTTimer::~TinkerIoTTimer() {
+    free(timers);
+    free(heap);
+}
+
+int TinkerIoTTimer::create(unsigned long interval, TinkerIoTTimerCallback callback, bool oneShot) {
+    int timerId = freeList;
+    if (timerId >= 0) {
+        freeList = timers[timerId].next;
+    } else {
+        if (slotCount == 0x10000) return -1;  // Slot bits of the id
+        if (slotCount == capacity) {
+            int grown = capacity ? capacity * 2 : 4;
+            TimerItem* newTimers = (TimerItem*)realloc(timers, grown * sizeof(TimerItem));
+            if (!newTimers) return -1;
+            timers = newTimers;
+            int* newHeap = (int*)realloc(heap, grown * sizeof(int));
+            if (!newHeap) return -1;
+            heap = newHeap;
+            capacity = grown;
+        }
+        timerId = slotCount++;
+        timers[timerId].generation = 0;
+    }
+
+    TimerItem& t = timers[timerId];
+    t.interval = interval;
+    t.due = millis() + interval;
+    t.callback = callback;
+    t.heapIndex = -1;
+    t.next = -1;
+    t.inUse = true;
+    t.enabled = true;  // Auto-enabled by default
+    t.oneShot = oneShot;
+    t.deferred = false;
+    activeCount++;
+    schedule(timerId);
+    return timerId | (t.generation << 16);
+}
+
+void TinkerIoTTimer::release(int timerId) {
+    unschedule(timerId);
+    timers[timerId].inUse = false;
+    timers[timerId].enabled = false;
+    timers[timerId].generation = (timers[timerId].generation + 1) & 0x7FFF;
+    activeCount--;
+    if (!timers[timerId].deferred) {  // Otherwise run() frees it when done
+        timers[timerId].next = freeList;
+        freeList = timerId;
+    }
+}
+
+void TinkerIoTTimer::siftUp(int pos) {
+    int timerId = heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) / 2;
+        if (!earlier(timerId, heap[parent])) break;
+        place(pos, heap[parent]);
+        pos = parent;
+    }
+    place(pos, timerId);
+}
+
+void TinkerIoTTimer::siftDown(int pos) {
+    int timerId = heap[pos];
+    for (;;) {
+        int child = 2 * pos + 1;
+        if (child >= heapSize) break;
+        if (child + 1 < heapSize && earlier(heap[child + 1], heap[child])) child++;
+        if (!earlier(heap[child], timerId)) break;
+        place(pos, heap[child]);
+        pos = child;
+    }
+    place(pos, timerId);
+}
+
+void TinkerIoTTimer::schedule(int timerId) {
+    place(heapSize++, timerId);
+    siftUp(heapSize - 1);
+}
+
+void TinkerIoTTimer::unschedule(int timerId) {
+    int pos = timers[timerId].heapIndex;
+    if (pos < 0) return;
+    timers[timerId].heapIndex = -1;
+    int last = heap[--heapSize];
+    if (pos == heapSize) return;
+    place(pos, last);
+    siftDown(pos);
+    siftUp(timers[last].heapIndex);
+}
+
+void TinkerIoTTimer::run() {
+    unsigned long now = millis();
+    int deferred = -1;  // interval 0 timers: back in the heap after this call
+
+    while (heapSize > 0) {
+        int timerId = heap[0];
+        if ((long)(now - timers[timerId].due) < 0) break;  // Earliest is not due
+        unschedule(timerId);
+
+        // Call the callback function. It may delete, disable, re-arm or
+        // create timers, including this one.
+        if (timers[timerId].callback) {
+            timers[timerId].callback();
+        }
+
+        TimerItem& t = timers[timerId];  // timers[] may have moved
+        if (!t.inUse || !t.enabled || t.heapIndex >= 0) continue;
+        if (t.oneShot) {
+            release(timerId);
+            continue;
+        }
+
+        // Stay on the grid; skip periods that are already over
+        unsigned long late = now - t.due;
+        if (t.interval == 0) {
+            t.due = now;
+            t.deferred = true;
+            t.next = deferred;
+            deferred = timerId;
+            continue;
+        }
+        unsigned long missed = late / t.interval;
+        overruns += missed;
+        t.due += (missed + 1) * t.interval;
+        schedule(timerId);
+    }
+
+    while (deferred >= 0) {
+        int timerId = deferred;
+        TimerItem& t = timers[timerId];
+        deferred = t.next;
+        t.deferred = false;
+        if (!t.inUse) {
+            t.next = freeList;  // Deleted by a later callback
+            freeList = timerId;
+        } else if (t.enabled && t.heapIndex < 0) {
+            schedule(timerId);
+        }
+    }
+}
+
+unsigned long TinkerIoTTimer::msUntilNext() {
+    if (heapSize == 0) return TINKERIOT_NO_DEADLINE;
+    long left = (long)(timers[heap[0]].due - millis());
+    return left > 0 ? (unsigned long)left : 0;
+}
+
+void TinkerIoTTimer::enable(int timerId) {
+    int slot = slotOf(timerId);
+    if (slot < 0) return;
+    unschedule(slot);
+    timers[slot].enabled = true;
+    timers[slot].due = millis() + timers[slot].interval;  // Reset timing
+    schedule(slot);
+}
+
+void TinkerIoTTimer::disable(int timerId) {
+    int slot = slotOf(timerId);
+    if (slot < 0) return;
+    timers[slot].enabled = false;
+    unschedule(slot);
+}
+
+void TinkerIoTTimer::changeInterval(int timerId, unsigned long newInterval) {
+    int slot = slotOf(timerId);
+    if (slot < 0) return;
+    timers[slot].interval = newInterval;
+    if (timers[slot].enabled) {
+        enable(timerId);  // Reset timing
+    }
+}
+
+void TinkerIoTTimer::deleteTimer(int timerId) {
+    int slot = slotOf(timerId);
+    if (slot >= 0) {
+        release(slot);
+    }
+}
+
+// ===== FRAME PARSER =====
+
+bool TinkerIoTView::toLong(long& out) const {
+    uint16_t i = 0;
+    bool negative = false;
+    if (length > 0 && data[0] == '-') {
+        negative = true;
+        i = 1;
+    }
+    if (i >= length || length - i > 9) return false;
+    long result = 0;
+    for (; i < length; i++) {
+        char c = data[i];
+        if (c < '0' || c > '9') return false;
+        result = result * 10 + (c - '0');
+    }
+    out = negative ? -result : result;
+    return true;
+}
+
+// Powers of ten that are exact in a float (5^10 < 2^24)
+static const float floatPowersOf10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+bool TinkerIoTView::toFloat(float& out) const {
+    uint16_t i = 0;
+    bool negative = false;
+    if (length > 0 && (data[0] == '-' || data[0] == '+')) {
+        negative = data[0] == '-';
+        i = 1;
+    }
+    uint32_t mantissa = 0;
+    uint8_t decimals = 0;
+    bool point = false;
+    bool digits = false;
+    for (; i < length; i++) {
+        char c = data[i];
+        if (c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (c < '0' || c > '9') return false;
+        mantissa = mantissa * 10 + (c - '0');
+        if (mantissa >= (1UL << 24)) return false;  // Not exact in a float any more
+        digits = true;
+        if (point) decimals++;
+    }
+    if (!digits || decimals > 10) return false;
+
+    // Both operands are exact, so the division is the only rounding
+    float result = (float)mantissa;
+    if (decimals) result /= floatPowersOf10[decimals];
+    out = negative ? -result : result;
+    return true;
+}
+
+// ===== FRAME BUILDER =====
+
+bool TinkerIoTFrameWriter::putInt(long value) {
+    char digits[12];
+    int n = 0;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[n++] = '0' + (magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (!reserve(n + (value < 0 ? 1 : 0))) return false;
+    if (value < 0) _buf[_length++] = '-';
+    while (n > 0) _buf[_length++] = digits[--n];
+    return true;
+}
+
+bool TinkerIoTFrameWriter::putFixed(double value, uint8_t decimals) {
+    if (isnan(value)) return putText("nan", 3);
+    if (isinf(value)) return value > 0 ? putText("inf", 3) : putText("-inf", 4);
+    if (decimals > 9) decimals = 9;
+
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+    bool negative = value < 0;
+    double magnitude = (negative ? -value : value) * scale + 0.5;
+    if (magnitude >= 18446744073709551615.0) return putText("ovf", 3);
+    uint64_t scaled = (uint64_t)magnitude;
+    uint32_t fraction;
+    char digits[21];
+    int n = 0;
+    if (scaled <= 0xFFFFFFFFUL) {
+        // Common case: 32-bit division only (no 64-bit helper calls on MCUs)
+        uint32_t whole = (uint32_t)scaled / scale;
+        fraction = (uint32_t)scaled % scale;
+        do {
+            digits[n++] = '0' + (whole % 10);
+            whole /= 10;
+        } while (whole);
+    } else {
+        uint64_t whole = scaled / scale;
+        fraction = (uint32_t)(scaled % scale);
+        do {
+            digits[n++] = '0' + (whole % 10);
+            whole /= 10;
+        } while (whole);
+    }
+
+    if (!reserve(n + (negative && scaled ? 1 : 0) + (decimals ? decimals + 1 : 0))) return false;
+    if (negative && scaled) _buf[_length++] = '-';
+    while (n > 0) _buf[_length++] = digits[--n];
+    if (decimals) {
+        _buf[_length++] = '.';
+        for (int i = decimals - 1; i >= 0; i--) {
+            _buf[_length + i] = '0' + (fraction % 10);
+            fraction /= 10;
+        }
+        _length += decimals;
+    }
+    return true;
 }
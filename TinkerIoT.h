@@ -15,6 +15,10 @@
 #elif defined(ARDUINO_SAMD_MKRWIFI1010)
   #include <WiFiNINA.h>
   #define TINKERIOT_BOARD "MKRWiFi1010"
+#elif defined(TINKERIOT_HOST)
+  // Linux host build against the stand-ins in extras/host/shim
+  #include <WiFi.h>
+  #define TINKERIOT_BOARD "Host"
 #else
   #error "Unsupported board! This library supports ESP32, ESP8266, Arduino Nano 33 IoT, and MKR WiFi 1010"
 #endif
@@ -33,6 +37,7 @@
     #define TINKERIOT_LOCK(mutex) portENTER_CRITICAL(&mutex)
     #define TINKERIOT_UNLOCK(mutex) portEXIT_CRITICAL(&mutex)
     #define TINKERIOT_HAS_FREERTOS 1
+    #define TINKERIOT_HAS_NETWORK_TASK 1
 
 #elif defined(ESP8266)
     // ESP8266: Use interrupt disable/enable for critical sections
@@ -50,6 +55,18 @@
     #define TINKERIOT_UNLOCK(mutex) interrupts()
     #define TINKERIOT_HAS_FREERTOS 0
 
+#elif defined(TINKERIOT_HOST)
+    // Host build: real threads, so use a real mutex
+    #include <mutex>
+    #include <condition_variable>
+    #include <thread>
+    #define TINKERIOT_MUTEX_TYPE std::mutex
+    #define TINKERIOT_MUTEX_INIT {}
+    #define TINKERIOT_LOCK(mutex) (mutex).lock()
+    #define TINKERIOT_UNLOCK(mutex) (mutex).unlock()
+    #define TINKERIOT_HAS_FREERTOS 0
+    #define TINKERIOT_HAS_NETWORK_TASK 1   // std::thread stands in for the FreeRTOS task
+
 #else
     // Generic Arduino: Use interrupt disable/enable as fallback
     #define TINKERIOT_MUTEX_TYPE uint8_t
@@ -61,12 +78,352 @@
 
 // Debug output control - enable/disable separately for connection vs data
 #define TINKERIOT_PRINT Serial          // Connection debug (WiFi, WebSocket, Login)
-#define TINKERIOT_DATA_DEBUG Serial     // Data transmission debug (cloudWrite, messages, protocol)
+
+// Data transmission debug (cloudWrite, messages, protocol) goes through the
+// deferred log instead (see LOGGING below): build with
+// -DTINKERIOT_LOG_LEVEL=... to choose how much of it is compiled in.
 
 // Usage examples:
-// Production: Comment out TINKERIOT_DATA_DEBUG, keep TINKERIOT_PRINT
-// Development: Enable both for full debugging
-// Silent: Comment out both for no debug output
+// Production: TINKERIOT_LOG_LEVEL 0 (or 1, errors only), keep TINKERIOT_PRINT
+// Development: both, with TINKERIOT_LOG_LEVEL 4 (every frame; default 2)
+// Silent: comment out TINKERIOT_PRINT and set TINKERIOT_LOG_LEVEL 0
+
+// ===== BUFFER SIZES =====
+// Defaults for the global TinkerIoT client; TinkerIoTClient<> takes its
+// own sizes as template arguments (see SIZED CLIENT below). They must be
+// the same for the sketch and the library (see BUILD CHECK).
+#ifndef TINKERIOT_PIN_COUNT
+#define TINKERIOT_PIN_COUNT 32                  // Cloud pins C0..C(n-1)
+#endif
+
+// Cloud pin values are stored inline, up to this many characters of text
+// per pin. Longer text is only sent directly: it is not queued offline,
+// deferred or coalesced, and a cr read returns its first characters.
+#ifndef TINKERIOT_MAX_VALUE_LEN
+#define TINKERIOT_MAX_VALUE_LEN 31
+#endif
+
+// Outgoing frames are encoded in place into one fixed transmit buffer
+// (5-byte header + body), so sending never touches the heap.
+#ifndef TINKERIOT_TX_BUFFER_SIZE
+#define TINKERIOT_TX_BUFFER_SIZE 256
+#endif
+
+// Digits after the point for float/double values sent as text, per pin
+// unless changed with setPrecision()
+#ifndef TINKERIOT_FLOAT_DECIMALS
+#define TINKERIOT_FLOAT_DECIMALS 2
+#endif
+
+// ===== INBOUND DRAIN =====
+// run() keeps calling webSocket.loop() while frames keep arriving, until
+// one of these budgets is used up (see setDrainBudget()). A larger budget
+// makes bursts of control commands land within one run(); a smaller one
+// gives the sketch's loop() the CPU back sooner.
+#ifndef TINKERIOT_DRAIN_MAX_FRAMES
+#define TINKERIOT_DRAIN_MAX_FRAMES 16
+#endif
+#ifndef TINKERIOT_DRAIN_MAX_US
+#define TINKERIOT_DRAIN_MAX_US 5000
+#endif
+
+// Counters for the drain loop in run() (see getDrainStats())
+struct TinkerIoTDrainStats {
+    uint32_t runs;                  // run() calls
+    uint32_t frames;                // WebSocket events handled in total
+    uint32_t budgetHits;            // Drains stopped by a budget with input left
+    uint16_t lastFrames;            // Events handled by the last run()
+    uint16_t maxFrames;
+    unsigned long lastMicros;       // Time the last drain took
+    unsigned long maxMicros;
+};
+
+// ===== NETWORK TASK =====
+// Opt-in mode (startNetworkTask()) where a dedicated task owns the
+// WebSocket: ESP32 FreeRTOS task pinned to a core, std::thread on the host.
+// Inbound HARDWARE frames reach the application task through one SPSC
+// ring, outbound frames leave through another. The connection state
+// (connected(), state()) is written by the network task as single words.
+#ifndef TINKERIOT_NET_QUEUE_SLOTS
+#define TINKERIOT_NET_QUEUE_SLOTS 8             // Frames per direction (power of two; TinkerIoTClient default)
+#endif
+#ifndef TINKERIOT_NET_FRAME_SIZE
+#define TINKERIOT_NET_FRAME_SIZE TINKERIOT_TX_BUFFER_SIZE   // Largest queued frame
+#endif
+#ifndef TINKERIOT_NET_TASK_STACK
+#define TINKERIOT_NET_TASK_STACK 8192
+#endif
+#ifndef TINKERIOT_NET_TASK_PRIORITY
+#define TINKERIOT_NET_TASK_PRIORITY 3           // Above the Arduino loop task (1)
+#endif
+#ifndef TINKERIOT_NET_SEND_WAIT_MS
+#define TINKERIOT_NET_SEND_WAIT_MS 50           // cloudWrite() wait on a full queue
+#endif
+
+// ===== STORE AND FORWARD =====
+// Replay pace for values buffered while offline (see enableOfflineBuffer()):
+// one frame of up to this many values per interval, so a long backlog does
+// not reach the server as one burst.
+#ifndef TINKERIOT_OFFLINE_REPLAY_BATCH
+#define TINKERIOT_OFFLINE_REPLAY_BATCH 16
+#endif
+#ifndef TINKERIOT_OFFLINE_REPLAY_INTERVAL_MS
+#define TINKERIOT_OFFLINE_REPLAY_INTERVAL_MS 50
+#endif
+
+#if defined(ESP32) || defined(ESP8266)
+  #include <FS.h>
+#elif defined(TINKERIOT_HOST)
+  #include <stdio.h>
+#endif
+
+// ===== ACKNOWLEDGED SENDS =====
+// With setAckWindow(), each HARDWARE frame the device sends carries a
+// message id and stays in flight until the server's RESPONSE with that id,
+// at most this many frames at a time. A write that finds the window full
+// is stored and sent with the next frame that fits (last value wins).
+#ifndef TINKERIOT_ACK_WINDOW
+#define TINKERIOT_ACK_WINDOW 8                  // Largest in-flight window (TinkerIoTClient default)
+#endif
+#ifndef TINKERIOT_ACK_TIMEOUT_MS
+#define TINKERIOT_ACK_TIMEOUT_MS 2000           // Unanswered frames count as lost after this
+#endif
+// A QUOTA_LIMIT answer spaces frames out: this many ms after the first,
+// doubling on each further one up to the maximum, and shrinking by an
+// eighth for every frame the server takes
+#ifndef TINKERIOT_QUOTA_BACKOFF_MS
+#define TINKERIOT_QUOTA_BACKOFF_MS 100
+#endif
+#ifndef TINKERIOT_QUOTA_MAX_INTERVAL_MS
+#define TINKERIOT_QUOTA_MAX_INTERVAL_MS 10000
+#endif
+
+// ===== ECHO =====
+// What goes back after a handler ran for an inbound cw (see setEchoPolicy()).
+// The RESPONSE to the frame is sent in every case; echoes of one inbound
+// frame share one HARDWARE frame.
+enum TinkerIoTEchoPolicy : uint8_t {
+    TINKERIOT_ECHO_ALWAYS = 0,      // The received value, right away
+    TINKERIOT_ECHO_NONE,            // Nothing: the RESPONSE acknowledges the write
+    TINKERIOT_ECHO_CHANGED,         // Only a value the handler wrote to the pin, if it differs
+    TINKERIOT_ECHO_COALESCED        // The pin's latest value, at most once per echo interval
+};
+#ifndef TINKERIOT_ECHO_POLICY
+#define TINKERIOT_ECHO_POLICY TINKERIOT_ECHO_ALWAYS    // Default of every pin
+#endif
+#ifndef TINKERIOT_ECHO_INTERVAL_MS
+#define TINKERIOT_ECHO_INTERVAL_MS 100
+#endif
+
+// ===== LATENCY =====
+// Durations are kept as log2 histograms: bucket 0 counts samples under
+// 64 us, bucket b those in [2^(b+5), 2^(b+6)) us, and the last one
+// everything from about 1 s up
+#define TINKERIOT_LATENCY_BUCKETS 16
+
+struct TinkerIoTHistogram {
+    uint32_t buckets[TINKERIOT_LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+
+    void add(uint32_t us) {
+        int bucket = us < 64 ? 0 : 26 - __builtin_clz(us);
+        buckets[bucket < TINKERIOT_LATENCY_BUCKETS ? bucket : TINKERIOT_LATENCY_BUCKETS - 1]++;
+        count++;
+        totalMicros += us;
+        if (us > maxMicros) maxMicros = us;
+    }
+    // Upper edge of the bucket holding the percent-th percentile (at most
+    // maxMicros): the true value is between half of it and it
+    uint32_t percentile(uint8_t percent) const;
+    uint32_t meanMicros() const { return count ? (uint32_t)(totalMicros / count) : 0; }
+};
+
+// See getLatencyStats()
+struct TinkerIoTLatencyStats {
+    TinkerIoTHistogram rtt;         // PING -> RESPONSE (setLatencyProbe())
+    TinkerIoTHistogram dispatch;    // Frame received -> its TINKERIOT_WRITE handler called
+    TinkerIoTHistogram handler;     // TINKERIOT_WRITE handler run time, every pin
+    uint32_t probes;                // PINGs sent
+    uint32_t probesLost;            // ... not answered before the next one
+    uint32_t lastRttMicros;
+    uint32_t reportsCut;            // setLatencyReport() texts cut to the pin's value length
+};
+
+// Run time of one pin's TINKERIOT_WRITE handler (see getHandlerTiming())
+struct TinkerIoTHandlerTiming {
+    uint32_t calls;
+    uint32_t maxMicros;
+    uint64_t totalMicros;
+};
+
+// ===== STATS =====
+// Runtime counters (see getStats()). Where two tasks may count (network
+// task builds) an update is one relaxed atomic add, elsewhere a plain add.
+// Either way the expression is the value before the add.
+#ifdef TINKERIOT_HAS_NETWORK_TASK
+#define TINKERIOT_COUNT(counter, n) __atomic_fetch_add(&(counter), (uint32_t)(n), __ATOMIC_RELAXED)
+#else
+#define TINKERIOT_COUNT(counter, n) (((counter) += (uint32_t)(n)) - (uint32_t)(n))
+#endif
+
+// Traffic is counted per command: these four, and everything else
+enum TinkerIoTStatsCommand {
+    TINKERIOT_STATS_RESPONSE,
+    TINKERIOT_STATS_LOGIN,
+    TINKERIOT_STATS_PING,
+    TINKERIOT_STATS_HARDWARE,
+    TINKERIOT_STATS_OTHER,
+    TINKERIOT_STATS_COMMANDS
+};
+
+struct TinkerIoTTraffic {
+    uint32_t frames;
+    uint32_t bytes;
+};
+
+// Only uint32_t fields, in export order (new ones go at the end)
+struct TinkerIoTStats {
+    TinkerIoTTraffic in[TINKERIOT_STATS_COMMANDS];     // Frames received
+    TinkerIoTTraffic out[TINKERIOT_STATS_COMMANDS];    // Frames handed to the socket
+    uint32_t droppedNotConnected;   // cloudWrite() with no session (and no offline buffer)
+    uint32_t droppedGrace;          // ... in the second after login
+    uint32_t droppedInvalidPin;
+    uint32_t reconnects;            // WebSocket connections after the first
+    uint32_t loginFailures;         // LOGINs refused or not answered
+    uint32_t handlerCalls;          // TINKERIOT_WRITE handlers run
+    uint32_t handlerMaxMicros;
+    uint32_t minFreeHeap;           // Bytes, 0 where the board does not tell
+    uint32_t largestFreeBlock;
+};
+
+#define TINKERIOT_STATS_FIELDS (sizeof(TinkerIoTStats) / sizeof(uint32_t))
+
+// exportStats() layout: version, field count, then every field as an
+// unsigned LEB128 varint (1 byte up to 127, at most 5)
+#define TINKERIOT_STATS_VERSION 1
+#define TINKERIOT_STATS_EXPORT_MAX (2 + TINKERIOT_STATS_FIELDS * 5)
+
+// Collector side of exportStats(): fields the exporter did not send stay
+// 0, ones this build does not know are skipped. False if malformed.
+bool tinkerIoTImportStats(const uint8_t* data, size_t length, TinkerIoTStats& stats);
+
+// ===== LOGGING =====
+// Data path events are not printed where they happen: each one stores a
+// fixed record - event id, micros(), up to three integers - in a RAM ring
+// and returns. The text is made later: by run() when it is idle (to
+// setLogOutput(), Serial by default), by printLog(), or on another machine
+// from records taken with readLog() (tinkerIoTFormatLog()). A full ring
+// overwrites its oldest records. run() only prints lines the output's
+// availableForWrite() has room for and leaves the rest in the ring, so a
+// Print that always reports 0 gets nothing from it: call printLog().
+//
+// TINKERIOT_LOG_LEVEL is the most verbose level compiled in. Calls above
+// it expand to nothing, arguments included; at 0 the ring and the format
+// table are gone too. setLogLevel() filters further at run time.
+#define TINKERIOT_LOG_OFF   0
+#define TINKERIOT_LOG_ERROR 1
+#define TINKERIOT_LOG_WARN  2
+#define TINKERIOT_LOG_INFO  3
+#define TINKERIOT_LOG_DEBUG 4
+
+#ifndef TINKERIOT_LOG_LEVEL
+#define TINKERIOT_LOG_LEVEL TINKERIOT_LOG_WARN
+#endif
+#ifndef TINKERIOT_LOG_RECORDS
+#if defined(ARDUINO_ARCH_SAMD)
+#define TINKERIOT_LOG_RECORDS 8         // 32 KB of RAM: 192 bytes of ring
+#else
+#define TINKERIOT_LOG_RECORDS 32        // Ring size (power of two), 24 bytes each
+#endif
+#endif
+#ifndef TINKERIOT_LOG_DRAIN_PER_RUN
+#define TINKERIOT_LOG_DRAIN_PER_RUN 4   // Records an idle run() prints
+#endif
+
+enum TinkerIoTLogEvent {
+    TINKERIOT_EV_INVALID_PIN,           // pin
+    TINKERIOT_EV_CANNOT_SEND,           // pin
+    TINKERIOT_EV_NOT_READY,             // state, login failed ('Y'/'N')
+    TINKERIOT_EV_GRACE,
+    TINKERIOT_EV_VALUE_TOO_LONG,        // pin
+    TINKERIOT_EV_CLOUD_WRITE,           // pin, value bytes, msg id
+    TINKERIOT_EV_BATCH_SENT,            // values
+    TINKERIOT_EV_BUFFERED,              // pin, backlog depth
+    TINKERIOT_EV_QUOTA_LIMIT,           // send interval ms
+    TINKERIOT_EV_ACK_TIMEOUT,           // msg id
+    TINKERIOT_EV_FRAME_IN,              // command, bytes
+    TINKERIOT_EV_TEXT_IN,               // bytes
+    TINKERIOT_EV_UNKNOWN_WS_EVENT,      // type
+    TINKERIOT_EV_SHORT_FRAME,           // bytes
+    TINKERIOT_EV_BODY_OVERRUN,          // body length, bytes
+    TINKERIOT_EV_COMMAND,               // command, msg id, body length
+    TINKERIOT_EV_PING,
+    TINKERIOT_EV_RESPONSE,              // status, msg id
+    TINKERIOT_EV_UNKNOWN_COMMAND,       // command
+    TINKERIOT_EV_HARDWARE_COMMAND,      // first two characters
+    TINKERIOT_EV_CLOUD_WRITE_IN,        // pin, value bytes, binary tag
+    TINKERIOT_EV_CLOUD_READ_IN,         // pin
+    TINKERIOT_EV_HANDLER_CALL,          // pin
+    TINKERIOT_EV_NO_HANDLER,            // pin
+    TINKERIOT_EV_MESSAGE_TOO_LONG,      // body bytes
+    TINKERIOT_EV_SEND_NOT_CONNECTED,    // command
+    TINKERIOT_EV_SEND,                  // command, msg id, body length
+    TINKERIOT_EV_QUEUE_FULL,            // bytes
+    TINKERIOT_EV_BAD_RECORD,            // pin, type, length
+    TINKERIOT_EV_REPORT_CUT,            // pin, report length, length sent
+    TINKERIOT_EV_COUNT
+};
+
+struct TinkerIoTLogRecord {
+    uint32_t sequence;                  // Ring position + 1, 0 while being written
+    uint32_t micros;
+    uint16_t event;                     // TinkerIoTLogEvent
+    uint8_t level;
+    uint8_t reserved;
+    int32_t args[3];
+};
+
+#if TINKERIOT_LOG_LEVEL > 0
+// One line of text for a record, as printLog() writes it (without the line
+// end). Works on records read back from readLog() on any machine.
+size_t tinkerIoTFormatLog(const TinkerIoTLogRecord& record, char* buffer, size_t size);
+#endif
+
+// For use inside TinkerIoTClass: TINKERIOT_LOGD(TINKERIOT_EV_SEND, command, id, length)
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_ERROR
+#define TINKERIOT_LOGE(...) logEvent(TINKERIOT_LOG_ERROR, __VA_ARGS__)
+#else
+#define TINKERIOT_LOGE(...) ((void)0)
+#endif
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_WARN
+#define TINKERIOT_LOGW(...) logEvent(TINKERIOT_LOG_WARN, __VA_ARGS__)
+#else
+#define TINKERIOT_LOGW(...) ((void)0)
+#endif
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_INFO
+#define TINKERIOT_LOGI(...) logEvent(TINKERIOT_LOG_INFO, __VA_ARGS__)
+#else
+#define TINKERIOT_LOGI(...) ((void)0)
+#endif
+#if TINKERIOT_LOG_LEVEL >= TINKERIOT_LOG_DEBUG
+#define TINKERIOT_LOGD(...) logEvent(TINKERIOT_LOG_DEBUG, __VA_ARGS__)
+#else
+#define TINKERIOT_LOGD(...) ((void)0)
+#endif
+
+// ===== IDLE WAITING =====
+// waitForEvent() sleeps until the next deadline. Where the socket cannot be
+// watched directly (every board; the host build polls it) it wakes at least
+// this often so run() can check for input - the bound on the extra latency
+// an inbound command sees while the loop sleeps.
+#ifndef TINKERIOT_WAIT_SLICE_MS
+#define TINKERIOT_WAIT_SLICE_MS 10
+#endif
+
+// msUntilNext() when nothing is scheduled
+#define TINKERIOT_NO_DEADLINE ((unsigned long)-1)
 
 // ===== CLOUD PIN CONSTANTS =====
 #define C0  0   
@@ -150,12 +507,198 @@ enum TinkerIoTStatus {
     SERVER_EXCEPTION = 19
 };
 
+// ===== BINARY VALUES =====
+// Opt-in compact encoding for HARDWARE values, negotiated at LOGIN. The
+// device asks with a LOGIN body of "fe\0<mask>" (decimal feature mask); a
+// server that supports it answers RESPONSE [SUCCESS][accepted mask]. A
+// plain one-byte RESPONSE (any older server) keeps values in ASCII.
+//
+// Once accepted, a value after "cw\0<pin>\0" may start with a tag byte.
+// Tags are below ' ', so they never collide with an ASCII value:
+//   0x01  int32    4 bytes, big-endian
+//   0x02  float32  4 bytes, IEEE 754, big-endian
+//   0x03  raw      2-byte big-endian length, then the bytes
+// The '\0' tuple separator follows the payload as usual.
+#ifndef TINKERIOT_BINARY_VALUES
+#define TINKERIOT_BINARY_VALUES 0       // Default for setBinaryValues()
+#endif
+#define TINKERIOT_FEATURE_BINARY_VALUES 0x01
+
+enum TinkerIoTValueTag {
+    TINKERIOT_TAG_INT32 = 0x01,
+    TINKERIOT_TAG_FLOAT32 = 0x02,
+    TINKERIOT_TAG_RAW = 0x03
+};
+
 // Forward declarations
 class TinkerIoTClass;
 
+// ===== CLOUD PIN STORAGE =====
+// One fixed-size slot per pin. Numbers are kept as scalars and formatted
+// when they are sent; text is kept inline. Updating a slot is a scalar
+// store or a short memcpy - no heap allocation.
+//
+// Each slot is a seqlock: the version is odd while a write is in progress
+// and readers retry until they copy the value between two equal even
+// versions. Readers never lock; writers serialize on a critical section
+// held only for the fixed-size copy.
+enum TinkerIoTValueType {
+    TINKERIOT_VALUE_EMPTY = 0,
+    TINKERIOT_VALUE_INT = 1,
+    TINKERIOT_VALUE_FLOAT = 2,
+    TINKERIOT_VALUE_TEXT = 3
+};
+
+struct TinkerIoTPinValue {
+    uint8_t type;                   // TinkerIoTValueType
+    uint8_t length;                 // Text length (TINKERIOT_VALUE_TEXT)
+    union {
+        int32_t asInt;
+        float asFloat;
+        char text[TINKERIOT_MAX_VALUE_LEN + 1];
+    };
+};
+
+// A value as the words a slot copies
+union TinkerIoTPinWords {
+    TinkerIoTPinValue value;
+    uint32_t words[(sizeof(TinkerIoTPinValue) + 3) / 4];
+};
+
+// Words per slot for values of up to valueLen characters: the version,
+// then the TinkerIoTPinValue prefix through text[valueLen]
+constexpr size_t tinkerIoTSlotWords(size_t valueLen) {
+    return 1 + (offsetof(TinkerIoTPinValue, text) + valueLen + 1 + 3) / 4;
+}
+
+// RAM used by the global client's pin table. Define TINKERIOT_PIN_TABLE_BUDGET
+// to fail the build when it grows past a limit, TINKERIOT_REPORT_RAM to print it.
+#define TINKERIOT_PIN_TABLE_BYTES (TINKERIOT_PIN_COUNT * tinkerIoTSlotWords(TINKERIOT_MAX_VALUE_LEN) * sizeof(uint32_t))
+#ifdef TINKERIOT_PIN_TABLE_BUDGET
+static_assert(TINKERIOT_PIN_TABLE_BYTES <= TINKERIOT_PIN_TABLE_BUDGET,
+              "TinkerIoT cloud pin table exceeds TINKERIOT_PIN_TABLE_BUDGET - lower TINKERIOT_MAX_VALUE_LEN");
+#endif
+#ifdef TINKERIOT_REPORT_RAM
+// The compiler prints the byte count as the template argument of this warning
+template <size_t Bytes> struct TinkerIoTRamReport {
+    __attribute__((deprecated("TinkerIoT RAM report - not an error"))) static void pinTable() {}
+};
+inline void tinkerIoTReportRam() { TinkerIoTRamReport<TINKERIOT_PIN_TABLE_BYTES>::pinTable(); }
+#endif
+
+// ===== CONNECTION STATE =====
+// run() walks the client through these phases. Nothing in begin() or the
+// WebSocket callbacks waits, so the sketch's loop() keeps running while
+// WiFi associates, the socket opens and the login round trip completes.
+// WiFi.begin() is issued again after this long without WiFi: WiFiNINA
+// (Nano 33 IoT, MKR WiFi 1010) does not reconnect on its own.
+#ifndef TINKERIOT_WIFI_RETRY_MS
+#define TINKERIOT_WIFI_RETRY_MS 10000
+#endif
+enum TinkerIoTState {
+    TINKERIOT_IDLE,                 // begin() not called (or no WiFi module)
+    TINKERIOT_WIFI_CONNECTING,      // Waiting for WiFi.status() == WL_CONNECTED
+    TINKERIOT_WS_CONNECTING,        // WebSocket (re)connecting
+    TINKERIOT_LOGGING_IN,           // Socket open, LOGIN sent or about to be
+    TINKERIOT_READY                 // Login accepted
+};
+
+// How long each phase of the last completed (re)connection took, in ms
+struct TinkerIoTConnectTimes {
+    unsigned long wifi;             // WiFi.begin() -> WL_CONNECTED (0 when WiFi stayed up)
+    unsigned long webSocket;        // WiFi up / socket lost -> WStype_CONNECTED
+    unsigned long login;            // Socket open -> login accepted
+    unsigned long total;            // Start of the attempt -> TINKERIOT_READY
+    uint16_t connections;           // Times TINKERIOT_READY was reached since begin()
+};
+
+// Per-pin reporting policy for numeric cloudWrite calls. A value is only
+// sent when it moved out of the deadband around the last sent value and
+// minInterval has passed; after maxSilence it is sent regardless.
+struct TinkerIoTReportPolicy {
+    float deadband;             // Minimum change to report (0 = any change)
+    bool deadbandPercent;       // deadband is a percentage of the last sent value
+    unsigned long minInterval;  // Minimum ms between sends (0 = no limit)
+    unsigned long maxSilence;   // Heartbeat: resend after this many ms (0 = never)
+};
+
 // Function pointer type for TinkerIoT write handlers
 typedef void (*TinkerIoTWriteHandler)(String value);
 
+// Typed write handlers (TINKERIOT_WRITE_INT/_FLOAT/_BOOL/_RAW): the value is
+// parsed once, straight from the received frame - no String, no param copy
+typedef void (*TinkerIoTIntHandler)(int value);
+typedef void (*TinkerIoTFloatHandler)(float value);
+typedef void (*TinkerIoTBoolHandler)(bool value);
+typedef void (*TinkerIoTRawHandler)(const char* value, size_t length);  // value is NUL-terminated
+
+// A registered handler of any of the kinds above
+struct TinkerIoTHandler {
+    enum Kind : uint8_t { NONE, STRING, INT, FLOAT, BOOL, RAW };
+    Kind kind;
+    union {
+        TinkerIoTWriteHandler asString;
+        TinkerIoTIntHandler asInt;
+        TinkerIoTFloatHandler asFloat;
+        TinkerIoTBoolHandler asBool;
+        TinkerIoTRawHandler asRaw;
+    };
+
+    TinkerIoTHandler() : kind(NONE), asString(nullptr) {}
+    TinkerIoTHandler(TinkerIoTWriteHandler fn) : kind(fn ? STRING : NONE), asString(fn) {}
+    TinkerIoTHandler(TinkerIoTIntHandler fn) : kind(fn ? INT : NONE), asInt(fn) {}
+    TinkerIoTHandler(TinkerIoTFloatHandler fn) : kind(fn ? FLOAT : NONE), asFloat(fn) {}
+    TinkerIoTHandler(TinkerIoTBoolHandler fn) : kind(fn ? BOOL : NONE), asBool(fn) {}
+    TinkerIoTHandler(TinkerIoTRawHandler fn) : kind(fn ? RAW : NONE), asRaw(fn) {}
+};
+
+// Reporting policy state of one pin (see setReportPolicy)
+struct TinkerIoTPinReport {
+    TinkerIoTReportPolicy policy;
+    float lastSent;                 // Last numeric value sent
+    unsigned long lastSentAt;       // millis() of the last send
+    bool active;                    // Policy set for this pin
+    bool hasSent;                   // lastSent/lastSentAt are valid
+    uint8_t decimals;               // Digits after the point for float/double (setPrecision())
+    bool reliable;                  // Sent again when its frame is lost (setReliable())
+    uint16_t pendingId;             // Reliable: message id of the unanswered frame carrying it
+    uint8_t echo;                   // TinkerIoTEchoPolicy after a handler ran (setEchoPolicy())
+};
+
+// A frame waiting for its RESPONSE (see setAckWindow())
+struct TinkerIoTInFlight {
+    uint16_t msgId;                 // 0: free slot
+    bool reliable;                  // Carries reliable pins (see pendingId)
+    unsigned long sentAt;
+};
+
+// Bytes of a network task queue of 'slots' frames of up to frameSize bytes
+// (each slot adds a 2-byte length, a 4-byte stamp and a NUL)
+constexpr size_t tinkerIoTRingBytes(size_t slots, size_t frameSize) {
+    return slots * (frameSize + 7);
+}
+
+// Where a client's per-pin tables and buffers live (see TinkerIoTClient)
+struct TinkerIoTTables {
+    uint16_t pins;
+    uint8_t valueLength;
+    uint8_t slotWords;
+    uint32_t* slots;                // pins * slotWords
+    TinkerIoTPinReport* reports;    // pins
+    TinkerIoTHandler* handlers;     // pins
+    TinkerIoTHandlerTiming* timings;    // pins
+    uint32_t* dirty;                // (pins + 31) / 32
+    uint32_t* echoes;               // (pins + 31) / 32
+    uint8_t* txBuffer;
+    uint16_t txBufferSize;
+    TinkerIoTInFlight* inFlight;    // ackWindow
+    uint8_t ackWindow;
+    uint8_t* netQueues;             // Two rings of netQueueSlots frames, nullptr without a network task
+    uint16_t netQueueSlots;
+    uint16_t netFrameSize;
+    const char* build;              // tinkerIoTBuild, see BUILD CHECK
+};
+
 // Function pointer type for timer callbacks
 typedef void (*TinkerIoTTimerCallback)();
 
@@ -165,7 +708,7 @@ class TinkerIoTAutoRegister {
 public:
     struct HandlerNode {
         int pin;
-        TinkerIoTWriteHandler handler;
+        TinkerIoTHandler handler;
         HandlerNode* next;
     };
     
@@ -174,7 +717,7 @@ private:
     
 public:
     // Constructor automatically registers the handler
-    TinkerIoTAutoRegister(int pin, TinkerIoTWriteHandler handler) {
+    TinkerIoTAutoRegister(int pin, TinkerIoTHandler handler) {
         HandlerNode* newNode = new HandlerNode;
         newNode->pin = pin;
         newNode->handler = handler;
@@ -184,8 +727,9 @@ public:
  
     }
     
-    // Static method to register all queued handlers
+    // Static method to register all queued handlers (with TinkerIoT by default)
     static void registerAll();
+    static void registerAll(TinkerIoTClass& client);
     
     // Static method to get handler count
     static int getHandlerCount();
@@ -206,110 +750,508 @@ public:
     }
     
     void setValue(String value) { _value = value; }
+    void setValue(const char* value) { _value = value; }  // reuses the existing buffer
 };
 
-// Timer class for TinkerIoT
-class TinkerIoTTimer {
+// ===== FRAME BUILDER =====
+// Encodes a TinkerIoT frame straight into a caller-owned buffer:
+//   [command][msg_id hi][msg_id lo][length hi][length lo][body...]
+// Never allocates. Appends that do not fit set an overflow flag and are
+// reported by finish(). One byte of capacity is held back so the body can
+// always be NUL-terminated (not counted in the frame length).
+class TinkerIoTFrameWriter {
 private:
-    struct TimerItem {
-        unsigned long interval;
-        unsigned long lastRun;
-        TinkerIoTTimerCallback callback;
-        bool enabled;
-    };
-    
-    #if defined(ARDUINO_SAMD_NANO_33_IOT) || defined(ARDUINO_SAMD_MKRWIFI1010)
-        static const int MAX_TIMERS = 8;  // Reduce for SAMD boards
-    #else
-        static const int MAX_TIMERS = 16;
-    #endif
-    TimerItem timers[MAX_TIMERS];
-    int timerCount;
-    
-public:
-    TinkerIoTTimer() : timerCount(0) {
-        for (int i = 0; i < MAX_TIMERS; i++) {
-            timers[i].enabled = false;
+    uint8_t* _buf;
+    size_t _capacity;
+    size_t _length;
+    bool _overflow;
+
+    bool reserve(size_t n) {
+        if (_overflow || _length + n >= _capacity) {
+            _overflow = true;
+            return false;
         }
+        return true;
     }
-    
-    // Set interval timer  - AUTO-ENABLED BY DEFAULT
-    int setInterval(unsigned long interval, TinkerIoTTimerCallback callback) {
-        if (timerCount >= MAX_TIMERS) return -1;
-        
-        timers[timerCount].interval = interval;
-        timers[timerCount].lastRun = millis();
-        timers[timerCount].callback = callback;
-        timers[timerCount].enabled = true;  // Auto-enabled by default
-        
-        return timerCount++;
+
+    bool putTagged(uint8_t tag, uint32_t bits) {
+        if (!reserve(5)) return false;
+        _buf[_length++] = tag;
+        _buf[_length++] = (bits >> 24) & 0xFF;
+        _buf[_length++] = (bits >> 16) & 0xFF;
+        _buf[_length++] = (bits >> 8) & 0xFF;
+        _buf[_length++] = bits & 0xFF;
+        return true;
     }
-    
-    // Set timeout timer (one-shot)
-    int setTimeout(unsigned long timeout, TinkerIoTTimerCallback callback) {
-        if (timerCount >= MAX_TIMERS) return -1;
-        
-        timers[timerCount].interval = timeout;
-        timers[timerCount].lastRun = millis();
-        timers[timerCount].callback = callback;
-        timers[timerCount].enabled = true;
-        
-        // Mark as timeout (negative interval after first run)
-        int timerId = timerCount++;
-        return timerId;
+
+public:
+    static const size_t HEADER_SIZE = 5;
+
+    TinkerIoTFrameWriter(uint8_t* buffer, size_t capacity)
+        : _buf(buffer), _capacity(capacity), _length(0), _overflow(false) {}
+
+    // Start a new frame, discarding anything written before
+    void begin(uint8_t command, uint16_t msg_id) {
+        _length = 0;
+        _overflow = _capacity <= HEADER_SIZE;
+        if (_overflow) return;
+        _buf[0] = command;
+        _buf[1] = (msg_id >> 8) & 0xFF;
+        _buf[2] = msg_id & 0xFF;
+        _length = HEADER_SIZE;
     }
-    
-    // Run all timers (call this in loop)
-    void run() {
-        unsigned long currentTime = millis();
-        
-        for (int i = 0; i < timerCount; i++) {
-            if (!timers[i].enabled) continue;
-            
-            if (currentTime - timers[i].lastRun >= timers[i].interval) {
-                timers[i].lastRun = currentTime;
-                
-                // Call the callback function
-                if (timers[i].callback) {
-                    timers[i].callback();
-                }
-                
-                // For setTimeout, disable after first run
-                if (timers[i].interval < 0) {
-                    timers[i].enabled = false;
-                }
-            }
-        }
+
+    bool putByte(uint8_t b) {
+        if (!reserve(1)) return false;
+        _buf[_length++] = b;
+        return true;
     }
-    
-    // Enable/disable timer
-    void enable(int timerId) {
-        if (timerId >= 0 && timerId < timerCount) {
-            timers[timerId].enabled = true;
-            timers[timerId].lastRun = millis(); // Reset timing
-        }
+
+    bool putSeparator() { return putByte(0); }
+
+    bool putText(const char* data, size_t len) {
+        if (!reserve(len)) return false;
+        memcpy(_buf + _length, data, len);
+        _length += len;
+        return true;
     }
-    
-    void disable(int timerId) {
-        if (timerId >= 0 && timerId < timerCount) {
-            timers[timerId].enabled = false;
+
+    bool putText(const char* str) { return putText(str, strlen(str)); }
+
+    // Decimal integer, no leading zeros
+    bool putInt(long value);
+
+    // Fixed-point decimal with 'decimals' digits after the point, rounded
+    // half away from zero ("nan"/"inf" for non-finite values)
+    bool putFixed(double value, uint8_t decimals);
+
+    // Tagged binary values (see TINKERIOT_FEATURE_BINARY_VALUES)
+    bool putTaggedInt(int32_t value) { return putTagged(TINKERIOT_TAG_INT32, (uint32_t)value); }
+
+    bool putTaggedFloat(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return putTagged(TINKERIOT_TAG_FLOAT32, bits);
+    }
+
+    bool putTaggedRaw(const void* data, size_t len) {
+        if (len > 0xFFFF || !reserve(3 + len)) return false;
+        _buf[_length++] = TINKERIOT_TAG_RAW;
+        _buf[_length++] = (len >> 8) & 0xFF;
+        _buf[_length++] = len & 0xFF;
+        memcpy(_buf + _length, data, len);
+        _length += len;
+        return true;
+    }
+
+    // "cw\0<pin>\0" - the value is appended by the caller
+    bool putCloudWriteHeader(int pin) {
+        return putText("cw", 2) && putSeparator() && putInt(pin) && putSeparator();
+    }
+
+    // Drop everything written after 'mark' (a previous length())
+    void rewind(size_t mark) {
+        _length = mark;
+        _overflow = false;
+    }
+
+    // NUL-terminate what has been written so far and return it from 'offset'
+    const char* textAt(size_t offset) {
+        _buf[_length] = 0;
+        return (const char*)_buf + offset;
+    }
+
+    // Patch the body length into the header and NUL-terminate the body.
+    // Returns the total frame size, or 0 if anything overflowed.
+    size_t finish() {
+        if (_overflow || _length - HEADER_SIZE > 0xFFFF) return 0;
+        uint16_t bodyLength = _length - HEADER_SIZE;
+        _buf[3] = (bodyLength >> 8) & 0xFF;
+        _buf[4] = bodyLength & 0xFF;
+        _buf[_length] = 0;
+        return _length;
+    }
+
+    uint8_t* data() { return _buf; }
+    uint16_t msgId() const { return (_buf[1] << 8) | _buf[2]; }
+    size_t length() const { return _length; }
+    bool overflowed() const { return _overflow; }
+};
+
+// ===== FRAME PARSER =====
+// Non-owning pointer/length view into a received frame
+struct TinkerIoTView {
+    const char* data;
+    uint16_t length;
+
+    bool equals(const char* str) const {
+        return strlen(str) == length && memcmp(data, str, length) == 0;
+    }
+
+    // Strict decimal integer (optional leading '-'); false on anything else
+    bool toLong(long& out) const;
+
+    // Plain decimal ("-12.5", "3", ".25") of up to 7 significant digits, the
+    // range dashboard widgets send; false on anything else (exponents,
+    // "nan", text). The digits form an integer below 2^24 divided by an
+    // exact power of ten, so the result is correctly rounded, like strtof().
+    bool toFloat(float& out) const;
+
+    // Payload of a TINKERIOT_TAG_INT32/FLOAT32 value
+    uint32_t toWord() const {
+        const uint8_t* b = (const uint8_t*)data;
+        return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+    }
+};
+
+// Splits a hardware body ("cw\0<pin>\0<value>") into its '\0'-separated
+// fields in place. No bytes are copied; each field is a view into the body.
+class TinkerIoTFrameReader {
+private:
+    const uint8_t* _pos;
+    const uint8_t* _end;
+    bool _done;
+
+public:
+    TinkerIoTFrameReader(const uint8_t* body, size_t length)
+        : _pos(body), _end(body + length), _done(false) {}
+
+    // Next field up to the following '\0' or the end of the body
+    bool next(TinkerIoTView& field) {
+        if (_done) return false;
+        const uint8_t* sep = (const uint8_t*)memchr(_pos, 0, _end - _pos);
+        if (sep == nullptr) {
+            sep = _end;
+            _done = true;
         }
+        field.data = (const char*)_pos;
+        field.length = sep - _pos;
+        _pos = sep + 1;
+        return true;
     }
-    
-    // Change interval
-    void changeInterval(int timerId, unsigned long newInterval) {
-        if (timerId >= 0 && timerId < timerCount) {
-            timers[timerId].interval = newInterval;
-            timers[timerId].lastRun = millis(); // Reset timing
+
+    // Next value field. With 'binary' set, a value starting with a tag byte
+    // is read by its length instead - the payload may contain '\0' - and
+    // 'tag' is set to it; 'tag' is 0 for an ASCII value. A truncated
+    // payload ends the body.
+    bool nextValue(TinkerIoTView& field, uint8_t& tag, bool binary) {
+        tag = 0;
+        if (!binary || _done || _pos >= _end || *_pos < TINKERIOT_TAG_INT32 || *_pos > TINKERIOT_TAG_RAW) {
+            return next(field);
+        }
+        size_t available = _end - _pos;
+        size_t header = *_pos == TINKERIOT_TAG_RAW ? 3 : 1;
+        size_t length = header == 3 && available >= 3 ? ((size_t)_pos[1] << 8) | _pos[2] : 4;
+        if (available < header || available - header < length) {
+            _done = true;
+            return false;
         }
+        tag = *_pos;
+        field.data = (const char*)_pos + header;
+        field.length = length;
+        _pos += header + length;
+        if (_pos == _end) {
+            _done = true;
+        } else if (*_pos == 0) {
+            _pos++;                     // Tuple separator
+        } else {
+            _done = true;               // Malformed: nothing can be framed after it
+        }
+        return true;
     }
-    
-    // Delete timer
-    void deleteTimer(int timerId) {
-        if (timerId >= 0 && timerId < timerCount) {
-            timers[timerId].enabled = false;
+
+    bool atEnd() const { return _done; }
+};
+
+// ===== FRAME QUEUE =====
+// Lock-free single-producer/single-consumer queue of whole frames. One task
+// may push() while another runs front()/pop() - no lock, no interrupts
+// disabled: each side owns one index and publishes it with release
+// stores. Frames are copied into fixed slots and NUL-terminated, so the
+// consumer can parse them in place (like arduinoWebSockets payloads). Each
+// frame carries a 32-bit stamp from the producer (the micros() it arrived).
+class TinkerIoTFrameRing {
+private:
+    uint8_t* _slots = nullptr;
+    uint16_t _slotSize = 0;             // Max frame length
+    uint16_t _count = 0;                // Slots, power of two
+    uint32_t _head = 0;                 // Next slot to fill (producer)
+    uint32_t _tail = 0;                 // Next slot to read (consumer)
+    uint32_t _dropped = 0;              // Full or oversized (producer)
+    uint16_t _peak = 0;                 // Highest depth seen (producer)
+
+    // [length lo][length hi][stamp, 4][frame][NUL]
+    uint8_t* slot(uint32_t index) { return _slots + (size_t)(index & (_count - 1)) * (_slotSize + 7u); }
+
+public:
+    TinkerIoTFrameRing() {}
+    TinkerIoTFrameRing(const TinkerIoTFrameRing&) = delete;
+    TinkerIoTFrameRing& operator=(const TinkerIoTFrameRing&) = delete;
+
+    // Use tinkerIoTRingBytes(count, slotSize) bytes at storage (count is a
+    // power of two); call before either side runs
+    void init(uint8_t* storage, uint16_t count, uint16_t slotSize) {
+        _slots = storage;
+        _count = count;
+        _slotSize = slotSize;
+        _head = _tail = 0;
+    }
+
+    // Producer side. False when full or too long; inbound frames are
+    // counted as dropped here, outbound ones by the caller (countDrop())
+    // once it stops waiting.
+    bool push(const uint8_t* frame, size_t length, bool countFull = false, uint32_t stamp = 0) {
+        uint32_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+        uint32_t depth = head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+        if (depth >= _count || length > _slotSize) {
+            if (countFull) countDrop();
+            return false;
         }
+        uint8_t* s = slot(head);
+        s[0] = length & 0xFF;
+        s[1] = length >> 8;
+        memcpy(s + 2, &stamp, sizeof(stamp));
+        memcpy(s + 6, frame, length);
+        s[6 + length] = 0;
+        if (depth + 1 > _peak) _peak = depth + 1;
+        __atomic_store_n(&_head, head + 1, __ATOMIC_RELEASE);
+        return true;
     }
+
+    // Consumer side: oldest frame (nullptr when empty), then pop() it
+    uint8_t* front(size_t& length, uint32_t* stamp = nullptr) {
+        uint32_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail) return nullptr;
+        uint8_t* s = slot(tail);
+        length = s[0] | (s[1] << 8);
+        if (stamp) memcpy(stamp, s + 2, sizeof(*stamp));
+        return s + 6;
+    }
+    void pop() { __atomic_store_n(&_tail, __atomic_load_n(&_tail, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE); }
+
+    bool full() { return __atomic_load_n(&_head, __ATOMIC_RELAXED) - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) >= _count; }
+    void countDrop() { __atomic_store_n(&_dropped, _dropped + 1, __ATOMIC_RELAXED); }
+    bool empty() { return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE); }
+    uint32_t pushed() { return __atomic_load_n(&_head, __ATOMIC_RELAXED); }
+    uint32_t dropped() { return __atomic_load_n(&_dropped, __ATOMIC_RELAXED); }
+    uint16_t peak() { return _peak; }
+};
+
+// Counters for the network task queues (see getNetworkStats())
+struct TinkerIoTNetworkStats {
+    uint32_t inboundFrames;         // HARDWARE/RESPONSE frames handed to the application task
+    uint32_t inboundDropped;        // Inbound ring full or frame too long
+    uint32_t outboundFrames;        // Frames queued by the application task
+    uint32_t outboundDropped;       // Outbound ring full or frame too long
+    uint16_t inboundPeak;           // Highest queue depth seen
+    uint16_t outboundPeak;
+};
+
+// Counters for acknowledged sends (see getAckStats())
+struct TinkerIoTAckStats {
+    uint32_t sent;                  // Frames sent with a message id
+    uint32_t acked;                 // ... answered SUCCESS
+    uint32_t rejected;              // ... answered with another error
+    uint32_t timedOut;              // ... unanswered in time, or in flight when the connection dropped
+    uint32_t quotaLimited;          // QUOTA_LIMIT answers (tracked frames or not)
+    uint32_t retransmits;           // Reliable pins queued again
+    uint32_t deferred;              // cloudWrite values held back by the window or pacing
+    uint8_t inFlight;               // Frames waiting for their RESPONSE
+    unsigned long sendInterval;     // Current spacing between frames after QUOTA_LIMIT, ms (0: none)
+};
+
+// ===== OFFLINE QUEUE =====
+// Backing store for values that overflow the offline RAM ring: a FIFO of
+// fixed-size records, oldest first. Implement it for any medium; see
+// TinkerIoTFileStore for a file on flash (or on the host).
+class TinkerIoTOfflineStore {
+public:
+    virtual ~TinkerIoTOfflineStore() {}
+    // Every record has recordSize bytes; layout names what they mean (pin
+    // count, value length). A backlog saved under another layout is discarded.
+    virtual bool begin(size_t recordSize, uint32_t layout) = 0;
+    virtual bool push(const uint8_t* record) = 0;           // Append, false when full
+    virtual bool read(uint32_t index, uint8_t* record) = 0; // index-th oldest
+    virtual void pop(uint32_t count) = 0;                   // Discard the oldest 'count'
+    virtual uint32_t count() = 0;
+};
+
+// Records in a file: a 12-byte header (record size, layout, records
+// already replayed) and then the records in order. The header is rewritten once
+// per replayed frame and the file is emptied once everything has been
+// replayed, so a backlog survives a reboot without wearing the flash per
+// value. ESP32/ESP8266: any fs::FS (LittleFS, SPIFFS, SD); host: a path.
+class TinkerIoTFileStore : public TinkerIoTOfflineStore {
+private:
+    const char* _path;
+    #if defined(ESP32) || defined(ESP8266)
+    fs::FS& _fs;
+    fs::File _file;
+    #elif defined(TINKERIOT_HOST)
+    FILE* _file = nullptr;
+    #endif
+    uint32_t _recordSize = 0;
+    uint32_t _layout = 0;
+    uint32_t _first = 0;                // Records replayed (header)
+    uint32_t _records = 0;              // Records in the file, replayed or not
+    uint32_t _maxRecords;
+
+    bool open(bool truncate);
+    bool writeAt(uint32_t offset, const uint8_t* data, size_t length);
+    bool readAt(uint32_t offset, uint8_t* data, size_t length);
+    uint32_t fileSize();
+    bool writeHeader();
+
+public:
+    #if defined(ESP32) || defined(ESP8266)
+    TinkerIoTFileStore(fs::FS& fs, const char* path, uint32_t maxRecords = 4096)
+        : _path(path), _fs(fs), _maxRecords(maxRecords) {}
+    #else
+    explicit TinkerIoTFileStore(const char* path, uint32_t maxRecords = 4096)
+        : _path(path), _maxRecords(maxRecords) {}
+    #endif
+    ~TinkerIoTFileStore();
+
+    bool begin(size_t recordSize, uint32_t layout) override;
+    bool push(const uint8_t* record) override;
+    bool read(uint32_t index, uint8_t* record) override;
+    void pop(uint32_t count) override;
+    uint32_t count() override { return _records - _first; }
+};
+
+struct TinkerIoTOfflineStats {
+    uint32_t depth;                 // Values waiting: RAM + store
+    uint32_t stored;                // ... of which in the store
+    uint32_t buffered;              // Values taken while offline, in total
+    uint32_t dropped;               // Discarded: oldest ones (RAM full, store full or absent), unreadable replays
+    uint32_t replayed;              // Buffered values sent after reconnecting, in total
+    uint32_t replayBacklog;         // Depth when the current replay started (0: none yet)
+    uint32_t replaySent;            // Values sent by the current replay
+    unsigned long oldestAgeMs;      // How far behind the replay is: age of the oldest waiting value
+};
+
+// RAM ring of fixed-size records in front of an optional store. When the
+// ring is full its oldest record moves to the store (or is dropped), so
+// the store always holds the older part of the queue and reading goes
+// store first, then RAM. Owned by the application task only.
+class TinkerIoTOfflineQueue {
+private:
+    uint8_t* _records = nullptr;
+    uint16_t _recordSize = 0;
+    uint16_t _capacity = 0;             // RAM records
+    uint32_t _head = 0;                 // Next RAM record to fill
+    uint32_t _tail = 0;                 // Oldest RAM record
+    TinkerIoTOfflineStore* _store = nullptr;
+
+    uint8_t* slot(uint32_t index) { return _records + (size_t)(index % _capacity) * _recordSize; }
+
+public:
+    uint32_t dropped = 0;
+
+    TinkerIoTOfflineQueue() {}
+    ~TinkerIoTOfflineQueue() { free(_records); }
+    TinkerIoTOfflineQueue(const TinkerIoTOfflineQueue&) = delete;
+    TinkerIoTOfflineQueue& operator=(const TinkerIoTOfflineQueue&) = delete;
+
+    bool init(uint16_t capacity, uint16_t recordSize, TinkerIoTOfflineStore* store);
+    bool enabled() const { return _capacity > 0; }
+    uint32_t depth() { return (_head - _tail) + stored(); }
+    uint32_t stored() { return _store ? _store->count() : 0; }
+    void push(const uint8_t* record);
+    bool read(uint32_t index, uint8_t* record);
+    void pop(uint32_t count);
+};
+
+// ===== TIMER =====
+// Deadline-ordered: enabled timers sit in a binary min-heap keyed on their
+// next due time, so run() only looks at the earliest one - O(1) when
+// nothing is due, O(log n) per timer that fires. Periodic timers stay on a
+// fixed grid (due += interval) and do not drift when run() is called late;
+// if whole periods were missed they are skipped (see getOverruns()) instead
+// of firing in a burst. There is no fixed limit: storage grows on demand
+// and ids of deleted or finished timers are reused.
+class TinkerIoTTimer {
+private:
+    struct TimerItem {
+        unsigned long interval;
+        unsigned long due;              // millis() of the next run
+        TinkerIoTTimerCallback callback;
+        int heapIndex;                  // Position in heap[], -1 when not scheduled
+        int next;                       // Free list / deferred list link
+        bool inUse;
+        bool enabled;
+        bool oneShot;
+        bool deferred;                  // On run()'s deferred list (interval 0)
+        uint16_t generation;            // Bumped on release: ids of the slot's earlier timers go stale
+    };
+
+    // Ids handed out are slot | generation << 16; inside, timers are
+    // handled by slot
+    TimerItem* timers = nullptr;        // Indexed by slot
+    int* heap = nullptr;                // Slots, earliest due first
+    int capacity = 0;
+    int slotCount = 0;                  // Slots handed out so far
+    int heapSize = 0;
+    int freeList = -1;                  // Released slots, ready for reuse
+    int activeCount = 0;
+    unsigned long overruns = 0;
+
+    int create(unsigned long interval, TinkerIoTTimerCallback callback, bool oneShot);
+    void release(int timerId);
+    // Slot of a live timer's id, -1 for anything else (stale, deleted, -1)
+    int slotOf(int timerId) const {
+        int slot = timerId & 0xFFFF;
+        if (timerId < 0 || slot >= slotCount || !timers[slot].inUse) return -1;
+        return timers[slot].generation == (timerId >> 16) ? slot : -1;
+    }
+    bool earlier(int a, int b) const { return (long)(timers[a].due - timers[b].due) < 0; }
+    void place(int pos, int timerId) { heap[pos] = timerId; timers[timerId].heapIndex = pos; }
+    void siftUp(int pos);
+    void siftDown(int pos);
+    void schedule(int timerId);
+    void unschedule(int timerId);
+
+public:
+    TinkerIoTTimer() {}
+    ~TinkerIoTTimer();
+    TinkerIoTTimer(const TinkerIoTTimer&) = delete;
+    TinkerIoTTimer& operator=(const TinkerIoTTimer&) = delete;
+
+    // Set interval timer  - AUTO-ENABLED BY DEFAULT. Returns the id, or -1
+    // when out of memory.
+    int setInterval(unsigned long interval, TinkerIoTTimerCallback callback) {
+        return create(interval, callback, false);
+    }
+
+    // Set timeout timer (one-shot): runs once, then its id goes stale
+    int setTimeout(unsigned long timeout, TinkerIoTTimerCallback callback) {
+        return create(timeout, callback, true);
+    }
+
+    // Run due timers (call this in loop). Each timer runs at most once per call.
+    void run();
+
+    // Enable/disable timer (enable restarts the interval from now)
+    void enable(int timerId);
+    void disable(int timerId);
+    bool isEnabled(int timerId) {
+        int slot = slotOf(timerId);
+        return slot >= 0 && timers[slot].enabled;
+    }
+
+    // Change interval (restarts the interval from now)
+    void changeInterval(int timerId, unsigned long newInterval);
+
+    // Delete timer. Ids are not reused: deleting one that is gone already
+    // (deleted, or a timeout that fired) does nothing.
+    void deleteTimer(int timerId);
+
+    int getNumTimers() { return activeCount; }
+    unsigned long getOverruns() { return overruns; }   // Periods skipped because run() was late
+
+    // ms until the earliest enabled timer is due (0 if overdue),
+    // TINKERIOT_NO_DEADLINE when none is
+    unsigned long msUntilNext();
 };
 
 // Enhanced TinkerIoT class with auto-registration support
@@ -318,11 +1260,64 @@ private:
     // WebSocket client
     WebSocketsClient webSocket;
     
-    // Connection state
-    bool isConnected = false;
-    bool loginSent = false;
+    // Connection state (advanced from run(), see TinkerIoTState). With a
+    // network task, connState, loginAttemptTime and binaryValues are written
+    // there and read by the application task too: atomic single-word
+    // accesses, connState stored last and read first.
+    TinkerIoTState connState = TINKERIOT_IDLE;
+    TinkerIoTState linkState() const { return __atomic_load_n(&connState, __ATOMIC_ACQUIRE); }
+    unsigned long loginTime() const { return __atomic_load_n(&loginAttemptTime, __ATOMIC_RELAXED); }
+    bool binaryActive() const { return __atomic_load_n(&binaryValues, __ATOMIC_RELAXED); }
+    unsigned long phaseStart = 0;       // millis() when connState was entered
+    unsigned long attemptStart = 0;     // millis() when this (re)connection began
+    unsigned long wifiBeginAt = 0;      // millis() of the last WiFi.begin()
+    TinkerIoTConnectTimes connectTimes = {0, 0, 0, 0, 0};
+    bool webSocketStarted = false;      // setupWebSocket() done; the library reconnects itself
+    bool loginPending = false;          // LOGIN sent, no RESPONSE yet (socket-owner task only)
     bool loginFailed = false;           // Track login failure
     bool tokenErrorReported = false;    // Track if token error was already reported
+    unsigned long loginDelay = 0;       // Wait after the socket opens before LOGIN
+    unsigned long lastWiFiCheck = 0;
+    #ifdef TINKERIOT_PRINT
+    unsigned long lastProgressDot = 0;
+    #endif
+
+    // Inbound drain (see TINKERIOT_DRAIN_MAX_FRAMES)
+    uint16_t drainMaxFrames = TINKERIOT_DRAIN_MAX_FRAMES;
+    unsigned long drainMaxMicros = TINKERIOT_DRAIN_MAX_US;
+    uint32_t socketEvents = 0;          // Bumped by webSocketEvent()
+    bool drainBudgetHit = false;        // Last drain stopped with input left
+    TinkerIoTDrainStats drainStats = {0, 0, 0, 0, 0, 0, 0};
+
+    // waitForEvent() wake-up (see notify())
+    #if defined(ESP32)
+    TaskHandle_t waitTask = nullptr;    // Task blocked in waitForEvent()
+    #elif defined(TINKERIOT_HOST)
+    std::mutex wakeLock;                // Network task mode: the socket
+    std::condition_variable wakeCond;   // belongs to the network thread
+    bool wakePending = false;
+    #else
+    volatile bool wakeRequested = false;
+    #endif
+
+    // Network task mode (see startNetworkTask())
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    volatile bool networkTaskActive = false;
+    bool networkStop = false;           // Set by stopNetworkTask() (atomic access)
+    TinkerIoTFrameRing inboundRing;     // Network task -> application (HARDWARE, RESPONSE)
+    TinkerIoTFrameRing outboundRing;    // Application -> network task (any frame)
+    #if defined(ESP32)
+    TaskHandle_t volatile networkTask = nullptr;
+    static void networkTaskEntry(void* arg);
+    #else
+    std::thread* networkThread = nullptr;
+    #endif
+    bool onNetworkTask();
+    void networkLoop();
+    void sendQueued();
+    void receiveQueued();
+    void wakeNetworkTask();
+    #endif
     
     // Server configuration - OPTIMIZED for dynamic assignment
     const char* server_host = "10.161.42.200";  // Change this to the server ip
@@ -334,33 +1329,189 @@ private:
     String wifi_ssid;
     String wifi_password;
     
-    // Cloud pins storage
-    String cloudPins[32];
+    // Per-pin tables, owned and sized by TinkerIoTClient
+    const uint16_t pinCount;
+    const uint8_t valueLength;          // Longest text a slot stores
+    const uint8_t slotWords;            // Words per cloudPins slot
+    uint32_t* const cloudPins;          // Versioned slots: [version, TinkerIoTPinValue words...]
+    TinkerIoTPinReport* const pinReports;
+    TinkerIoTHandler* const writeHandlers;
+    TinkerIoTHandlerTiming* const handlerTimings;
+    TinkerIoTInFlight* const inFlight;  // ackCapacity slots
+    const uint8_t ackCapacity;          // Largest ackWindow
+    uint8_t* const netQueues;           // inboundRing, then outboundRing
+    const uint16_t netQueueSlots;       // Network task queue depth (0: no network task)
+    const uint16_t netFrameSize;
+
+    bool silenceWatch = false;          // Any pin has a maxSilence heartbeat
+    unsigned long silenceDue = 0;       // Earliest time a heartbeat may be due
+
+    // Reusable transmit buffer - every outgoing frame is encoded here
+    TinkerIoTFrameWriter txFrame;
+
+    // Open batch: cloudWrite appends tuples to txFrame until commitBatch()
+    bool batchOpen = false;
+    uint8_t batchCount = 0;             // Tuples in the frame being built
+
+    // Serializes cloudPins[] writers and guards dirtyPins; readers of
+    // cloudPins[] go by the slot versions and never take it
+    TINKERIOT_MUTEX_TYPE pinWriteMutex = TINKERIOT_MUTEX_INIT;
+
+    // Coalescing mode: cloudWrite only stores the value and marks the pin
+    // dirty (bit n % 32 of word n / 32 = Cn, guarded by pinWriteMutex); run()
+    // sends the latest value of each dirty pin once per flush interval
+    bool coalesceWrites = false;
+    unsigned long coalesceInterval = 100;
+    unsigned long lastFlush = 0;
+    uint32_t* const dirtyPins;
+    bool hasDirtyPins();
+
+    // Store and forward: values cloudWrite could not send wait here, as
+    // records [pin hi][pin lo][type][length][millis, 4][value], and go out
+    // replayBatch at a time once the connection is usable again
+    TinkerIoTOfflineQueue offlineQueue;
+    uint8_t replayBatch = TINKERIOT_OFFLINE_REPLAY_BATCH;
+    unsigned long replayInterval = TINKERIOT_OFFLINE_REPLAY_INTERVAL_MS;
+    unsigned long lastReplay = 0;
+    uint32_t offlineBuffered = 0;
+    uint32_t offlineReplayed = 0;
+    uint32_t replayBacklog = 0;
+    uint32_t replaySent = 0;
+    bool replaying = false;
+    size_t offlineRecordSize() const { return (8 + valueLength + 1 + 3) & ~(size_t)3; }
+    uint32_t offlineLayout() const { return ((uint32_t)pinCount << 16) | valueLength; }
+    bool holdOffline(int pin);
+    void bufferValue(int pin, uint8_t type, const void* data, size_t length);
+    void bufferValue(int pin, const char* text) { bufferValue(pin, TINKERIOT_VALUE_TEXT, text, strlen(text)); }
+    void bufferValue(int pin, int value) { int32_t v = value; bufferValue(pin, TINKERIOT_VALUE_INT, &v, sizeof(v)); }
+    void bufferValue(int pin, double value) { float v = value; bufferValue(pin, TINKERIOT_VALUE_FLOAT, &v, sizeof(v)); }
+    void replayOffline();
+    unsigned long replayDue();
+
+    // Acknowledged sends: frames with a message id wait in inFlight[] for
+    // their RESPONSE. Pins a full window or QUOTA_LIMIT pacing held back
+    // are dirty, and run() flushes them once a frame may go out.
+    uint8_t ackWindow = 0;              // 0: frames go out with id 0, untracked
+    unsigned long ackTimeout = TINKERIOT_ACK_TIMEOUT_MS;
+    uint16_t lastMsgId = 1;             // LOGIN is 1
+    uint8_t inFlightCount = 0;
+    bool frameReliable = false;         // txFrame carries a reliable pin
+    bool deferredPins = false;
+    unsigned long sendInterval = 0;     // Pacing after QUOTA_LIMIT
+    unsigned long lastFrameSent = 0;
+    unsigned long lastQuotaLimit = 0;
+    TinkerIoTAckStats ackStats = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    uint16_t nextMsgId();
+    bool sendWindowOpen();
+    void frameSent();
+    void handleAck(uint16_t msg_id, uint8_t status);
+    void expireAcks();
+    unsigned long ackDue();
+    void settlePins(uint16_t msg_id, bool resend);
+
+    // Echo policies (see setEchoPolicy()). While a CHANGED or COALESCED
+    // handler runs, its cloudWrite to echoCapturePin is only stored.
+    int echoCapturePin = -1;
+    bool echoCaptured = false;
+    bool echoPending = false;           // Coalesced echoes are marked in dirtyPins and echoPins
+    uint32_t* const echoPins;           // Same layout as dirtyPins, guarded by pinWriteMutex
+    unsigned long echoMarkedAt = 0;
+    unsigned long echoInterval = TINKERIOT_ECHO_INTERVAL_MS;
+    void markEcho(int pin);
+    void flushEchoes();
+    unsigned long echoDue();
 
-    // Mutex for protecting cloudPins[] array from race conditions
-    TINKERIOT_MUTEX_TYPE cloudPinsMutex = TINKERIOT_MUTEX_INIT;
+    // Latency probe and handler timing (see setLatencyProbe())
+    unsigned long probeInterval = 0;    // 0: no PINGs
+    unsigned long lastProbe = 0;
+    uint16_t probeId = 0;               // Unanswered PING (0: none)
+    uint32_t probeSentAt = 0;           // micros()
+    uint32_t rxMicros = 0;              // When the frame being handled arrived
+    int latencyPin = -1;                // Published on this pin (-1: not published)
+    unsigned long latencyInterval = 0;
+    unsigned long lastLatencyReport = 0;
+    TinkerIoTLatencyStats latency = {};
+    void sendProbe();
+    void publishLatency();
+
+    // Runtime counters (see getStats())
+    TinkerIoTStats counters = {};
+    bool sessionSeen = false;           // A WebSocket connection was up before
+    void countFrame(TinkerIoTTraffic* traffic, const uint8_t* frame, size_t length);
+    void sampleHeap();
+
+    // Deferred log (see LOGGING)
+    #if TINKERIOT_LOG_LEVEL > 0
+    TinkerIoTLogRecord logRing[TINKERIOT_LOG_RECORDS] = {};
+    uint32_t logHead = 0;               // Claimed by writers (TINKERIOT_COUNT)
+    uint32_t logTail = 0;               // Next to read (application task)
+    uint32_t logLost = 0;               // Overwritten before they were read
+    uint8_t logLevel = TINKERIOT_LOG_LEVEL;
+    Print* logOutput = &Serial;
+    bool logStalled = false;            // run() found no room in logOutput
+    void logEvent(uint8_t level, uint16_t event, int32_t a = 0, int32_t b = 0, int32_t c = 0);
+    bool takeLog(TinkerIoTLogRecord& record);
+    uint16_t writeLog(Print& out, uint16_t max, bool whenRoom);
+    #endif
 
     // Timing
-    unsigned long lastHeartbeat = 0;
-    const unsigned long heartbeatInterval = 5000;
     unsigned long loginAttemptTime = 0;         // Track login attempt time
+    bool binaryRequested = TINKERIOT_BINARY_VALUES;  // Ask for binary values at LOGIN
+    bool binaryValues = false;                  // Accepted by the server for this session
     const unsigned long loginTimeout = 10000;  // 10 second login timeout
     unsigned long firstConnectionAttempt = 0;   // Track first connection attempt
     int connectionFailureCount = 0;             // Count connection failures
     
-    // Write handlers array
-    TinkerIoTWriteHandler writeHandlers[32] = {nullptr};
-    
     // Private methods
     void connectToWiFi();
     void setupWebSocket();
+    void runConnection();
+    void setState(TinkerIoTState next);
+    void drainSocket();
     void sendLogin();
-    void handleTinkerIoTMessage(uint8_t* data, size_t length);
+    // queued: taken from inboundRing, whose RESPONSE frames the network
+    // task has already told apart from the login answer
+    void handleTinkerIoTMessage(uint8_t* data, size_t length, bool queued = false);
     void handleHardwareCommand(uint16_t msg_id, uint8_t* body, uint16_t length);
+    void sendTinkerIoTMessage(uint8_t command, uint16_t msg_id, const uint8_t* body, uint16_t length);
     void sendTinkerIoTMessage(uint8_t command, uint16_t msg_id, String body);
     void sendHardwareMessage(uint16_t msg_id, String body);
+    void sendFrame(TinkerIoTFrameWriter& frame);
+    void transmit(uint8_t* data, size_t length);
+    bool beginCloudWrite(int pin, bool storeOnly);
+    bool fitsSlot(const char* text) { return strlen(text) <= valueLength; }
+    template <typename T> bool fitsSlot(T) { return true; }
+    bool readyToSend();
+    void sendBatchFrame();
+
+    // Pin table access (seqlock: storePin() locks for one fixed-size copy,
+    // loadPin() never locks)
+    void storePin(int pin, uint8_t type, const void* data, size_t length, bool markDirty = false);
+    void storePin(int pin, const char* text, bool markDirty = false) { storePin(pin, TINKERIOT_VALUE_TEXT, text, strlen(text), markDirty); }
+    void storePin(int pin, int value, bool markDirty = false) { int32_t v = value; storePin(pin, TINKERIOT_VALUE_INT, &v, sizeof(v), markDirty); }
+    void storePin(int pin, double value, bool markDirty = false) { float v = value; storePin(pin, TINKERIOT_VALUE_FLOAT, &v, sizeof(v), markDirty); }
+    void loadPin(int pin, TinkerIoTPinValue& out);
+
+    // Value sources for appendPinValue()
+    struct StoredValue { int pin; };    // Current cloudPins[] entry
+    void putValue(int pin, const char* value);
+    void putValue(int pin, int value);
+    void putValue(int pin, double value);
+    void putValue(int pin, StoredValue stored);
+    void putValue(int pin, const TinkerIoTPinValue& value);
+    template <typename T> bool appendPinValue(int pin, T value, size_t& valueStart);
+    template <typename T> bool writePin(int pin, T value);
+    template <typename T> void writeNumber(int pin, T value);
+    bool shouldReport(int pin, double value);
+    void sendSilentPins();
+    void openBatch();
+    uint32_t sendPins(int firstPin, uint32_t pins);
+    void sendStoredPin(int pin, uint16_t msg_id = 0);
     void sendResponse(uint16_t msg_id, uint8_t status);
-    void cloudRead(int pin, String value);
+    template <typename T> void cloudRead(int pin, T value, size_t length);
+    void callHandler(int pin, const char* value, size_t length);
+    void callHandler(int pin, int value, size_t length);
+    void callHandler(int pin, float value, size_t length);
     
     // Static WebSocket event handler
     static void webSocketEventStatic(WStype_t type, uint8_t * payload, size_t length);
@@ -369,33 +1520,261 @@ private:
     // Static instance pointer for callback
     static TinkerIoTClass* instance;
 
+    #ifdef TINKERIOT_HOST
+    friend struct TinkerIoTHostAccess;  // extras/host benchmarks drive private paths
+    #endif
+
+protected:
+    // Tables come from TinkerIoTClient, which is what sketches instantiate
+    explicit TinkerIoTClass(const TinkerIoTTables& tables);
+
 public:
-    // Constructor
-    TinkerIoTClass();
+    TinkerIoTClass(const TinkerIoTClass&) = delete;
+    TinkerIoTClass& operator=(const TinkerIoTClass&) = delete;
+    uint16_t pins() const { return pinCount; }
     
     // ENHANCED begin methods with auto-registration
     void begin(const char* auth_token, const char* ssid, const char* password);
     void begin(const char* auth_token, const char* ssid, const char* password, const char* server, int port = 8008);
     void run();
+
+    // Low-power loop: instead of spinning on run(), sleep until something
+    // is due. msUntilNext() is the time until the client's next internal
+    // deadline (login timeout, coalescing flush, heartbeat, latency probe,
+    // WiFi check).
+    // waitForEvent() blocks until inbound data, notify() or that deadline,
+    // capped at maxWaitMs. runUntilIdle() is one loop() iteration: run(),
+    // timer->run() and then waitForEvent() up to the timer's next deadline.
+    unsigned long msUntilNext();
+    void waitForEvent(unsigned long maxWaitMs = TINKERIOT_NO_DEADLINE);
+    void runUntilIdle(TinkerIoTTimer* timer = nullptr);
+    void notify();                  // Wake waitForEvent() (any task or ISR)
+
+    // Inbound drain budget per run(): stop after maxFrames WebSocket events
+    // or maxMicros, whichever comes first (0 = no limit for that budget)
+    void setDrainBudget(uint16_t maxFrames, unsigned long maxMicros);
+    const TinkerIoTDrainStats& getDrainStats() { return drainStats; }
+    void resetDrainStats();
+
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    // Dual-core mode: a dedicated task (pinned to 'core' on ESP32) runs the
+    // WebSocket, TLS, login and PING replies, so a slow TINKERIOT_WRITE
+    // handler no longer delays them. Handlers still run in run() on the
+    // calling task. Call after begin(); false for a client built with
+    // NetQueueSlots 0.
+    bool startNetworkTask(int core = 0);
+    void stopNetworkTask();
+    bool networkTaskRunning() { return networkTaskActive; }
+    TinkerIoTNetworkStats getNetworkStats();
+    #endif
     
     // Data sending methods (Device → App)
+    void cloudWrite(int pin, const char* value);
     void cloudWrite(int pin, String value);
     void cloudWrite(int pin, int value);
     void cloudWrite(int pin, float value);
     void cloudWrite(int pin, double value);
+
+    // Reporting policies for cloudWrite(int/float/double)
+    void setReportPolicy(int pin, const TinkerIoTReportPolicy& policy);
+    void clearReportPolicy(int pin);
+
+    // Digits after the point when cloudWrite(float/double) values are sent
+    // as text (default TINKERIOT_FLOAT_DECIMALS, at most 9)
+    void setPrecision(int pin, uint8_t decimals);
+
+    // Batched writes: cloudWrite calls in between share one frame
+    void beginBatch();
+    void commitBatch();
+
+    // Coalescing mode (last value wins per pin)
+    void setCoalescing(bool enabled, unsigned long flushIntervalMs = 100);
+    void flush();                                      // Send all dirty pins now
+
+    // Store and forward: cloudWrite values that cannot be sent (offline,
+    // logging in, post-login grace period) are queued instead of dropped -
+    // up to 'entries' in RAM, older ones spilled to 'store' if given - and
+    // replayed in order after login, paced by setOfflineReplay(). Writes
+    // made while a replay is still running queue behind it, so the last
+    // value the dashboard gets is the newest. Coalesced pins are not queued:
+    // they stay dirty until the next flush. Call once, before begin().
+    bool enableOfflineBuffer(uint16_t entries, TinkerIoTOfflineStore* store = nullptr);
+    void setOfflineReplay(uint8_t valuesPerFrame, unsigned long intervalMs);
+    TinkerIoTOfflineStats getOfflineStats();
+
+    // Acknowledged sends: up to 'frames' (at most the client's AckWindow)
+    // HARDWARE frames carry a message id and wait for the server's
+    // RESPONSE; 0 turns tracking off and frames go out with id 0 (the
+    // default). Needs a server that answers device frames. QUOTA_LIMIT
+    // answers slow the sending down with or without a window.
+    void setAckWindow(uint8_t frames, unsigned long timeoutMs = TINKERIOT_ACK_TIMEOUT_MS);
+    // The pin's current value is sent again when the frame that carried it
+    // times out or is refused with QUOTA_LIMIT (needs an ack window)
+    void setReliable(int pin, bool reliable = true);
+    TinkerIoTAckStats getAckStats();
+
+    // Echo after a write handler ran (default TINKERIOT_ECHO_POLICY). With
+    // CHANGED and COALESCED, the handler's own cloudWrite to the pin is
+    // taken as the echo instead of going out on its own. Coalesced echoes
+    // go out together, intervalMs after the first one was due.
+    void setEchoPolicy(int pin, TinkerIoTEchoPolicy policy);
+    void setEchoPolicy(TinkerIoTEchoPolicy policy);    // Every pin
+    void setEchoInterval(unsigned long intervalMs);
+
+    // Latency: every intervalMs (0 = off, the default) a PING goes out and
+    // the time to its RESPONSE is added to the RTT histogram. The time from
+    // a frame's arrival to its handler and the handlers' run times are
+    // always recorded. setLatencyReport() publishes a summary on a cloud
+    // pin every intervalMs (pin -1 = off) as the text
+    // "<rtt p50>,<rtt p99>,<rtt max>,<handler p99>,<handler max>": RTT in
+    // ms, handler time in us, percentiles to the histogram's factor of two.
+    // A text longer than the client's ValueLen loses its last fields
+    // (counted in reportsCut).
+    void setLatencyProbe(unsigned long intervalMs);
+    void setLatencyReport(int pin, unsigned long intervalMs);
+    const TinkerIoTLatencyStats& getLatencyStats() { return latency; }
+    TinkerIoTHandlerTiming getHandlerTiming(int pin);
+    void resetLatencyStats();
+
+    // Runtime counters since start-up or resetStats(): frames and bytes by
+    // command each way, dropped cloudWrites by reason, reconnects, login
+    // failures, handler runs, and the heap low-water mark (since boot on
+    // ESP32). exportStats() packs a snapshot for a fleet collector into at
+    // most TINKERIOT_STATS_EXPORT_MAX bytes and returns its length (0 if
+    // size is too small); tinkerIoTImportStats() reads it back.
+    TinkerIoTStats getStats();
+    size_t exportStats(uint8_t* buffer, size_t size);
+    void resetStats();
+
+    // Deferred log (see LOGGING). readLog() and printLog() take up to max
+    // records off the ring, oldest first, and return how many they took.
+    #if TINKERIOT_LOG_LEVEL > 0
+    void setLogLevel(uint8_t level) { logLevel = level; }
+    void setLogOutput(Print* out) { logOutput = out; }  // nullptr: run() leaves the ring alone
+    uint16_t readLog(TinkerIoTLogRecord* records, uint16_t max);
+    uint16_t printLog(Print& out, uint16_t max = 0xFFFF);  // Waits for the output
+    uint32_t getLogLost() { return logLost; }
+    #else
+    void setLogLevel(uint8_t) {}
+    void setLogOutput(Print*) {}
+    uint16_t readLog(TinkerIoTLogRecord*, uint16_t) { return 0; }
+    uint16_t printLog(Print&, uint16_t = 0xFFFF) { return 0; }
+    uint32_t getLogLost() { return 0; }
+    #endif
     
     // Connection status
-    bool connected() { return isConnected && loginSent; }
-    bool loginSuccess() { return loginSent; }           // Check if login was successful
+    bool connected() { return linkState() == TINKERIOT_READY; }
+    bool loginSuccess() { return linkState() == TINKERIOT_READY; }  // Check if login was successful
     bool loginFailing() { return loginFailed; }        // Check if login failed
-    bool websocketConnected() { return isConnected; }  // Check WebSocket connection only
+    bool websocketConnected() { return linkState() >= TINKERIOT_LOGGING_IN; }  // Check WebSocket connection only
+    TinkerIoTState state() { return linkState(); }
+    const TinkerIoTConnectTimes& connectionTimes() { return connectTimes; }
+
+    // Delay between the socket opening and LOGIN (default 0, was a fixed 1 s)
+    void setLoginDelay(unsigned long ms) { loginDelay = ms; }
+
+    // Compact binary values (see TINKERIOT_FEATURE_BINARY_VALUES): asked for
+    // at the next LOGIN, used while the server has accepted them
+    void setBinaryValues(bool enabled) { binaryRequested = enabled; }
+    bool binaryValuesActive() { return binaryActive(); }
     
     // Handler registration (internal use)
-    void _registerWriteHandler(int pin, TinkerIoTWriteHandler handler);
+    void _registerWriteHandler(int pin, TinkerIoTHandler handler);
+};
+
+// ===== BUILD CHECK =====
+// These settings change the layout of TinkerIoTClass, and the ones below
+// also change the global client. Arduino compiles the library without the
+// sketch's #defines, so a sketch that sets one would disagree with
+// TinkerIoT.cpp about where members live. Instead, both sides name their
+// symbols after the values: a mismatch fails to link, with an undefined
+// reference to tinkerIoTBuild_v31_a8_... or TinkerIoT_p32_..., and cannot
+// corrupt memory. Size a client with TinkerIoTClient<> template arguments;
+// change these only with flags that reach every file (PlatformIO
+// build_flags, the host Makefile's CPPFLAGS).
+#define TINKERIOT_STRINGIFY2(x) #x
+#define TINKERIOT_STRINGIFY(x) TINKERIOT_STRINGIFY2(x)
+#define TINKERIOT_BUILD_TAG                                                                   \
+    "v" TINKERIOT_STRINGIFY(TINKERIOT_MAX_VALUE_LEN) "_l" TINKERIOT_STRINGIFY(TINKERIOT_LOG_LEVEL) \
+    "_r" TINKERIOT_STRINGIFY(TINKERIOT_LOG_RECORDS)
+#define TINKERIOT_GLOBAL_TAG                                                                  \
+    "p" TINKERIOT_STRINGIFY(TINKERIOT_PIN_COUNT) "_t" TINKERIOT_STRINGIFY(TINKERIOT_TX_BUFFER_SIZE) \
+    "_q" TINKERIOT_STRINGIFY(TINKERIOT_NET_QUEUE_SLOTS) "_a" TINKERIOT_STRINGIFY(TINKERIOT_ACK_WINDOW) \
+    "_f" TINKERIOT_STRINGIFY(TINKERIOT_NET_FRAME_SIZE) "_" TINKERIOT_BUILD_TAG
+
+// Defined in TinkerIoT.cpp; every TinkerIoTClient passes its address on
+extern const char tinkerIoTBuild[] __asm__("tinkerIoTBuild_" TINKERIOT_BUILD_TAG);
+
+// ===== SIZED CLIENT =====
+// The per-pin tables (value slots, report policies, handlers and their
+// timings, dirty bits), the transmit buffer, the in-flight window and the
+// network task queues are members of TinkerIoTClient, so their sizes are
+// template arguments: an 8-pin node on a small board only pays for 8
+// slots, a gateway can go past C31. The protocol code is shared by every
+// instantiation. Handlers declared with TINKERIOT_WRITE register with the
+// client whose begin() runs.
+//
+//   TinkerIoTClient<8, 15> node;   // 8 pins, values up to 15 characters
+//
+// Pin numbers arrive from the server, so they are still checked against
+// the client's pin count at run time. ValueLen can only shrink the slots:
+// values are copied out through TinkerIoTPinValue, which holds
+// TINKERIOT_MAX_VALUE_LEN. The deferred log stays one ring per build
+// (TINKERIOT_LOG_RECORDS).
+//
+// The storage is a base class so that it is built before TinkerIoTClass.
+template <uint16_t Pins, uint8_t ValueLen, uint16_t TxBufferSize, uint16_t NetQueueSlots, uint8_t AckWindow>
+struct TinkerIoTClientStorage {
+    uint32_t slots[Pins * tinkerIoTSlotWords(ValueLen)];
+    TinkerIoTPinReport reports[Pins];
+    TinkerIoTHandler handlers[Pins];
+    TinkerIoTHandlerTiming timings[Pins];
+    uint32_t dirty[(Pins + 31) / 32];
+    uint32_t echoes[(Pins + 31) / 32];
+    uint8_t txBuffer[TxBufferSize];
+    TinkerIoTInFlight inFlight[AckWindow > 0 ? AckWindow : 1];
+    #ifdef TINKERIOT_HAS_NETWORK_TASK
+    uint8_t netQueues[NetQueueSlots > 0 ? 2 * tinkerIoTRingBytes(NetQueueSlots, TINKERIOT_NET_FRAME_SIZE) : 1];
+    uint8_t* queues() { return NetQueueSlots > 0 ? netQueues : nullptr; }
+    #else
+    uint8_t* queues() { return nullptr; }
+    #endif
+};
+
+template <uint16_t Pins,
+          uint8_t ValueLen = TINKERIOT_MAX_VALUE_LEN,
+          uint16_t TxBufferSize = TINKERIOT_TX_BUFFER_SIZE,
+          uint16_t NetQueueSlots = TINKERIOT_NET_QUEUE_SLOTS,
+          uint8_t AckWindow = TINKERIOT_ACK_WINDOW>
+class TinkerIoTClient : private TinkerIoTClientStorage<Pins, ValueLen, TxBufferSize, NetQueueSlots, AckWindow>,
+                        public TinkerIoTClass {
+    static_assert(Pins > 0, "TinkerIoTClient needs at least one pin");
+    static_assert(ValueLen <= TINKERIOT_MAX_VALUE_LEN, "ValueLen exceeds TINKERIOT_MAX_VALUE_LEN - raise it");
+    static_assert(TxBufferSize >= 64, "TinkerIoTClient transmit buffer is too small");
+    static_assert((NetQueueSlots & (NetQueueSlots - 1)) == 0, "NetQueueSlots must be a power of two (or 0: no network task)");
+
+    typedef TinkerIoTClientStorage<Pins, ValueLen, TxBufferSize, NetQueueSlots, AckWindow> Storage;
+
+    static TinkerIoTTables tablesOf(Storage& s) {
+        TinkerIoTTables tables = { Pins, ValueLen, (uint8_t)tinkerIoTSlotWords(ValueLen), s.slots, s.reports,
+                                   s.handlers, s.timings, s.dirty, s.echoes, s.txBuffer, TxBufferSize, s.inFlight,
+                                   AckWindow, s.queues(), NetQueueSlots, TINKERIOT_NET_FRAME_SIZE,
+                                   tinkerIoTBuild };
+        return tables;
+    }
+
+public:
+    static const uint16_t pinCapacity = Pins;
+    static const size_t storageBytes = sizeof(Storage);    // Tables + buffers
+
+    TinkerIoTClient() : Storage(), TinkerIoTClass(tablesOf(*this)) {}
 };
 
-// Global TinkerIoT object
-extern TinkerIoTClass TinkerIoT;
+typedef TinkerIoTClient<TINKERIOT_PIN_COUNT> TinkerIoTDefaultClient;
+
+// Global TinkerIoT object (TinkerIoTGlobal.cpp: only linked into sketches
+// that use it)
+extern TinkerIoTDefaultClient TinkerIoT __asm__("TinkerIoT_" TINKERIOT_GLOBAL_TAG);
 
 // Global parameter object
 extern TinkerIoTParam param;
@@ -408,6 +1787,31 @@ extern TinkerIoTParam param;
     TinkerIoTAutoRegister autoReg##pin(pin, tinkerIoTWriteHandler##pin); \
     void tinkerIoTWriteHandler##pin(String value)
 
+// Typed variants: the handler gets the parsed value. param is not updated.
+//   TINKERIOT_WRITE_INT(C1)   { analogWrite(LED, value); }       // int value
+//   TINKERIOT_WRITE_FLOAT(C2) { setpoint = value; }              // float value
+//   TINKERIOT_WRITE_BOOL(C3)  { digitalWrite(RELAY, value); }    // "1"/"true"/"on"
+//   TINKERIOT_WRITE_RAW(C4)   { lcd.print(value); }              // const char* value, size_t length
+#define TINKERIOT_WRITE_INT(pin) \
+    void tinkerIoTWriteHandler##pin(int value); \
+    TinkerIoTAutoRegister autoReg##pin(pin, tinkerIoTWriteHandler##pin); \
+    void tinkerIoTWriteHandler##pin(int value)
+
+#define TINKERIOT_WRITE_FLOAT(pin) \
+    void tinkerIoTWriteHandler##pin(float value); \
+    TinkerIoTAutoRegister autoReg##pin(pin, tinkerIoTWriteHandler##pin); \
+    void tinkerIoTWriteHandler##pin(float value)
+
+#define TINKERIOT_WRITE_BOOL(pin) \
+    void tinkerIoTWriteHandler##pin(bool value); \
+    TinkerIoTAutoRegister autoReg##pin(pin, tinkerIoTWriteHandler##pin); \
+    void tinkerIoTWriteHandler##pin(bool value)
+
+#define TINKERIOT_WRITE_RAW(pin) \
+    void tinkerIoTWriteHandler##pin(const char* value, size_t length); \
+    TinkerIoTAutoRegister autoReg##pin(pin, tinkerIoTWriteHandler##pin); \
+    void tinkerIoTWriteHandler##pin(const char* value, size_t length)
+
 // Convenience macro for connected callback  
 #define TINKERIOT_CONNECTED() void tinkerIoTConnectedHandler()
 
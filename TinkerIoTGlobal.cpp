@@ -0,0 +1,10 @@
+#include "TinkerIoT.h"
+
+// The global client lives in a file of its own. The library is linked as
+// an archive (dot_a_linkage in library.properties), so a sketch that only
+// uses its own TinkerIoTClient<> does not carry this one as well.
+TinkerIoTDefaultClient TinkerIoT;
+
+void TinkerIoTAutoRegister::registerAll() {
+    registerAll(TinkerIoT);
+}
@@ -0,0 +1,236 @@
+// Acknowledged sends against a rate-limited, lossy server, on the virtual clock.
+//
+//   build/tinkeriot_ack [--seconds=600] [--rate=20] [--quota=20] [--loss=0.1] [--latency=40]
+//                       [--window=8] [--timeout=2000]
+//
+// Four sensor pins (C1..C4) each write an increasing number at --rate Hz,
+// and C0 holds a state that changes every ten seconds. The server side
+// takes --quota HARDWARE frames per second and answers the rest with
+// QUOTA_LIMIT; --loss of the device's frames never arrive; answers come
+// back --latency ms later. Frames with a message id are answered SUCCESS.
+// Four clients run the same script:
+//
+//   blind       the previous behaviour: id 0, answers ignored
+//   id 0        no window, but QUOTA_LIMIT answers pace the sending
+//   window      setAckWindow(--window, --timeout)
+//   reliable    the same and setReliable(C0)
+//
+// Reported per client: frames sent, refused and lost, sensor values the
+// server took (out of those written), and how long in total the server's
+// C0 differed from the device's ("C0 stale", 0 is best). Exit status 1 if
+// the reliable client ended with a stale C0.
+//
+// A lost frame holds its window slot until --timeout: on a lossy link a
+// small window with a long timeout caps the frame rate well below the
+// quota (try --window=2 --timeout=5000).
+#include <TinkerIoT.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct TinkerIoTHostAccess {
+    // Undo the QUOTA_LIMIT pacing, as the library before it would
+    static void ignoreQuota(TinkerIoTClass& client) { client.sendInterval = 0; }
+};
+
+struct Options {
+    unsigned seconds = 600;
+    unsigned rate = 20;
+    unsigned quota = 20;
+    double loss = 0.1;
+    unsigned latency = 40;
+    unsigned window = 8;
+    unsigned long timeout = TINKERIOT_ACK_TIMEOUT_MS;
+};
+
+static Options options;
+
+// Server side
+struct Answer {
+    unsigned long due;
+    uint8_t frame[6];
+};
+static std::vector<Answer> answers;
+static unsigned long quotaSecond = 0;
+static unsigned quotaUsed = 0;
+static uint32_t lossState = 12345;
+static long serverC0 = -1;
+static long framesSent = 0, framesRefused = 0, framesLost = 0, valuesTaken = 0;
+
+static bool lost() {
+    lossState = lossState * 1103515245u + 12345u;
+    return ((lossState >> 8) & 0xFFFF) < options.loss * 65536;
+}
+
+static void answer(const uint8_t* frame, uint8_t status) {
+    Answer a = { millis() + options.latency, { RESPONSE, frame[1], frame[2], 0, 1, status } };
+    answers.push_back(a);
+}
+
+static void onDeviceFrame(const uint8_t* frame, size_t length, void*) {
+    if (frame[0] == LOGIN) {
+        uint8_t ok[] = { RESPONSE, frame[1], frame[2], 0, 1, SUCCESS };
+        TinkerIoTHost::linkDeliver(ok, sizeof(ok));
+        return;
+    }
+    if (frame[0] != HARDWARE) return;
+    framesSent++;
+    if (lost()) {
+        framesLost++;
+        return;
+    }
+
+    unsigned long second = millis() / 1000;
+    if (second != quotaSecond) {
+        quotaSecond = second;
+        quotaUsed = 0;
+    }
+    if (++quotaUsed > options.quota) {
+        framesRefused++;
+        answer(frame, QUOTA_LIMIT);
+        return;
+    }
+    bool tracked = frame[1] || frame[2];
+    if (tracked) answer(frame, SUCCESS);
+
+    TinkerIoTFrameReader reader(frame + 5, length - 5);
+    TinkerIoTView command, pin, value;
+    while (reader.next(command) && reader.next(pin) && reader.next(value)) {
+        long number;
+        if (!value.toLong(number)) continue;
+        if (pin.equals("0")) {
+            serverC0 = number;
+        } else {
+            valuesTaken++;
+        }
+    }
+}
+
+struct Result {
+    long written;
+    long sent;
+    long refused;
+    long lost;
+    long taken;
+    unsigned long staleMs;
+    bool staleAtEnd;
+    TinkerIoTAckStats stats;
+};
+
+static Result runScript(TinkerIoTClass& client, bool blind) {
+    answers.clear();
+    serverC0 = -1;
+    framesSent = framesRefused = framesLost = valuesTaken = 0;
+    client.begin("ack-token", "ssid", "password", "127.0.0.1", 8008);
+
+    // Log in and get past the post-login grace period
+    unsigned long start = millis();
+    while (millis() - start < 1500) {
+        client.run();
+        TinkerIoTHost::advanceMillis(1);
+    }
+
+    Result result = {};
+    long seq = 0, deviceC0 = 0;
+    unsigned long period = 1000 / options.rate;
+    unsigned long nextWrite = millis(), nextState = millis();
+    unsigned long end = millis() + options.seconds * 1000UL;
+    while ((long)(millis() - end) < 0) {
+        unsigned long now = millis();
+        if ((long)(now - nextState) >= 0) {
+            client.cloudWrite(C0, (int)++deviceC0);
+            nextState += 10000;
+        }
+        if ((long)(now - nextWrite) >= 0) {
+            for (int pin = C1; pin <= C4; pin++) client.cloudWrite(pin, (int)seq);
+            seq++;
+            result.written += 4;
+            nextWrite += period;
+        }
+
+        for (size_t i = 0; i < answers.size();) {
+            if ((long)(now - answers[i].due) >= 0) {
+                TinkerIoTHost::linkDeliver(answers[i].frame, sizeof(answers[i].frame));
+                answers.erase(answers.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        client.run();
+        if (blind) TinkerIoTHostAccess::ignoreQuota(client);
+        if (serverC0 != deviceC0) result.staleMs++;
+        TinkerIoTHost::advanceMillis(1);
+    }
+
+    result.sent = framesSent;
+    result.refused = framesRefused;
+    result.lost = framesLost;
+    result.taken = valuesTaken;
+    result.staleAtEnd = serverC0 != deviceC0;
+    result.stats = client.getAckStats();
+    return result;
+}
+
+static void report(const char* name, const Result& r) {
+    printf("%-10s %8ld %8ld %8ld %8ld/%-8ld %9lu %8u %8u %8u\n", name, r.sent, r.refused, r.lost, r.taken,
+           r.written, r.staleMs, r.stats.timedOut, r.stats.retransmits, r.stats.deferred);
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = (unsigned)atoi(arg + 10);
+        } else if (strncmp(arg, "--rate=", 7) == 0) {
+            options.rate = (unsigned)atoi(arg + 7);
+        } else if (strncmp(arg, "--quota=", 8) == 0) {
+            options.quota = (unsigned)atoi(arg + 8);
+        } else if (strncmp(arg, "--loss=", 7) == 0) {
+            options.loss = atof(arg + 7);
+        } else if (strncmp(arg, "--latency=", 10) == 0) {
+            options.latency = (unsigned)atoi(arg + 10);
+        } else if (strncmp(arg, "--window=", 9) == 0) {
+            options.window = (unsigned)atoi(arg + 9);
+        } else if (strncmp(arg, "--timeout=", 10) == 0) {
+            options.timeout = (unsigned long)atol(arg + 10);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds=600] [--rate=20] [--quota=20] [--loss=0.1] [--latency=40] "
+                            "[--window=8] [--timeout=2000]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (options.rate < 1 || options.rate > 1000 || options.seconds < 1 || options.loss < 0 || options.loss >= 1 ||
+        options.window < 1 || options.window > TINKERIOT_ACK_WINDOW) {
+        return 2;
+    }
+
+    TinkerIoTHost::useVirtualClock(true);
+    TinkerIoTHost::linkSetSink(onDeviceFrame, nullptr);
+
+    printf("4 pins x %u values/s, quota %u frames/s, %.0f%% loss, %u ms latency, %u s, window %u / %lu ms\n",
+           options.rate, options.quota, options.loss * 100, options.latency, options.seconds, options.window,
+           options.timeout);
+    printf("%-10s %8s %8s %8s %17s %9s %8s %8s %8s\n", "client", "sent", "refused", "lost", "values taken",
+           "C0 stale", "timeouts", "resent", "deferred");
+
+    TinkerIoTDefaultClient* blind = new TinkerIoTDefaultClient;
+    report("blind", runScript(*blind, true));
+
+    TinkerIoTDefaultClient* paced = new TinkerIoTDefaultClient;
+    report("id 0", runScript(*paced, false));
+
+    TinkerIoTDefaultClient* window = new TinkerIoTDefaultClient;
+    window->setAckWindow(options.window, options.timeout);
+    report("window", runScript(*window, false));
+
+    TinkerIoTDefaultClient* reliable = new TinkerIoTDefaultClient;
+    reliable->setAckWindow(options.window, options.timeout);
+    reliable->setReliable(C0);
+    Result result = runScript(*reliable, false);
+    report("reliable", result);
+
+    return result.staleAtEnd ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ===== HEAP COUNTING =====
+// glibc exports the real allocator as __libc_*; wrapping the public names
+// here catches String, operator new and everything else in the process.
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+}
+
+static uint64_t heapAllocs = 0;
+static uint64_t heapBytes = 0;
+
+extern "C" void* malloc(size_t size) {
+    __atomic_add_fetch(&heapAllocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&heapBytes, size, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&heapAllocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&heapBytes, count * size, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) {
+    __atomic_add_fetch(&heapAllocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&heapBytes, size, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+namespace bench {
+
+uint64_t wireBytes = 0;
+
+uint64_t allocCount() {
+    return __atomic_load_n(&heapAllocs, __ATOMIC_RELAXED);
+}
+
+uint64_t allocBytes() {
+    return __atomic_load_n(&heapBytes, __ATOMIC_RELAXED);
+}
+
+uint64_t nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void Suite::add(const char* name, Case fn) {
+    Entry entry;
+    entry.name = name;
+    entry.fn = fn;
+    _cases.push_back(entry);
+}
+
+Result Suite::measure(const char* name, const Case& fn, double minSeconds) {
+    fn(16);  // Warm up caches and any lazily grown buffers
+
+    uint64_t iterations = 1;
+    Result result;
+    result.name = name;
+    for (;;) {
+        uint64_t allocs0 = allocCount();
+        uint64_t bytes0 = allocBytes();
+        uint64_t wire0 = wireBytes;
+        uint64_t start = nowNanos();
+        fn(iterations);
+        uint64_t elapsed = nowNanos() - start;
+
+        if (elapsed >= minSeconds * 1e9 || iterations >= (1ULL << 40)) {
+            result.iterations = iterations;
+            result.nsPerOp = (double)elapsed / iterations;
+            result.allocsPerOp = (double)(allocCount() - allocs0) / iterations;
+            result.bytesPerOp = (double)(allocBytes() - bytes0) / iterations;
+            result.wireBytesPerOp = (double)(wireBytes - wire0) / iterations;
+            return result;
+        }
+        iterations *= 2;
+    }
+}
+
+int Suite::run(int argc, char** argv) {
+    bool json = false;
+    const char* filter = nullptr;
+    double minSeconds = 0.2;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = true;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+            minSeconds = atof(argv[i] + 11);
+        } else {
+            fprintf(stderr, "usage: %s [--json] [--filter=<substring>] [--min-time=<seconds>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    if (!json) {
+        printf("%-40s %14s %12s %10s %10s %10s\n", _name.c_str(), "iterations", "ns/op", "allocs/op", "B/op", "wire B/op");
+    }
+    for (size_t i = 0; i < _cases.size(); i++) {
+        if (filter && strstr(_cases[i].name.c_str(), filter) == nullptr) continue;
+        Result r = measure(_cases[i].name.c_str(), _cases[i].fn, minSeconds);
+        results.push_back(r);
+        if (!json) {
+            printf("%-40s %14llu %12.1f %10.2f %10.1f %10.1f\n", r.name.c_str(), (unsigned long long)r.iterations,
+                   r.nsPerOp, r.allocsPerOp, r.bytesPerOp, r.wireBytesPerOp);
+            fflush(stdout);
+        }
+    }
+
+    if (json) {
+        printf("{\"suite\":\"%s\",\"results\":[", _name.c_str());
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            printf("%s\n  {\"name\":\"%s\",\"iterations\":%llu,\"ns_per_op\":%.2f,\"allocs_per_op\":%.3f,"
+                   "\"bytes_per_op\":%.2f,\"wire_bytes_per_op\":%.2f}",
+                   i ? "," : "", r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp,
+                   r.allocsPerOp, r.bytesPerOp, r.wireBytesPerOp);
+        }
+        printf("\n]}\n");
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,66 @@
+// Minimal benchmark harness for the host build.
+//
+// Each case receives an iteration count and loops itself; the harness
+// doubles the count until a case runs for at least --min-time and reports
+// ns/op, heap allocations/op, heap bytes/op and bytes put on the wire/op.
+// Heap traffic is counted by interposing malloc/calloc/realloc (glibc).
+#ifndef TINKERIOT_BENCH_H
+#define TINKERIOT_BENCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Heap allocations since process start (malloc/calloc/realloc calls, bytes requested)
+uint64_t allocCount();
+uint64_t allocBytes();
+
+// Bytes handed to the WebSocket link; benchmarks add to it from their sink
+extern uint64_t wireBytes;
+
+// Keep a value alive so the optimizer cannot drop the work producing it
+template <typename T> inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+uint64_t nowNanos();
+
+struct Result {
+    std::string name;
+    uint64_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+    double wireBytesPerOp;
+};
+
+class Suite {
+public:
+    typedef std::function<void(uint64_t iterations)> Case;
+
+    explicit Suite(const char* name) : _name(name) {}
+
+    void add(const char* name, Case fn);
+
+    // Parses --json, --filter=<substring>, --min-time=<seconds>; returns exit code
+    int run(int argc, char** argv);
+
+    // Runs one case and returns its measurement (used by custom reports)
+    Result measure(const char* name, const Case& fn, double minSeconds);
+
+private:
+    struct Entry {
+        std::string name;
+        Case fn;
+    };
+    std::string _name;
+    std::vector<Entry> _cases;
+};
+
+} // namespace bench
+
+#endif // TINKERIOT_BENCH_H
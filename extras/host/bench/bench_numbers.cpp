@@ -0,0 +1,165 @@
+// Number formatting and parsing: the frame writer and TinkerIoTView
+// against the Arduino String path they replace.
+//
+//   build/tinkeriot_number_bench            round-trip check, then the table
+//   build/tinkeriot_number_bench --json     table only, machine-readable
+//
+// The round-trip check walks every value a dashboard widget can send in
+// the covered ranges - integers up to +-100000 and fixed-point values with
+// 1, 2 and 3 decimals up to 7 significant digits - written as the widget
+// writes them. Each must parse (TinkerIoTView::toFloat) to exactly the
+// float strtof() gives, and putFixed() at that many decimals must give the
+// same text back. Exit status 1 on any mismatch.
+//
+// The host String is the shim's (snprintf based), so the String rows show
+// the shape of the cost - a heap buffer per value - more than a board's
+// exact numbers; compare on the target for those.
+#include <TinkerIoT.h>
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Text of k / 10^decimals as a widget writes it ("-12.50" for -1250, 2)
+static int widgetText(long k, int decimals, char* out) {
+    if (decimals == 0) return sprintf(out, "%ld", k);
+    long scale = 1;
+    for (int i = 0; i < decimals; i++) scale *= 10;
+    unsigned long magnitude = k < 0 ? -k : k;
+    return sprintf(out, "%s%lu.%0*lu", k < 0 ? "-" : "", magnitude / scale, decimals, magnitude % scale);
+}
+
+static bool roundTrip(bool verbose) {
+    struct Range {
+        int decimals;
+        long limit;                     // |k| up to this
+    };
+    static const Range ranges[] = { { 0, 100000 }, { 1, 1000000 }, { 2, 1000000 }, { 3, 1000000 } };
+
+    uint8_t buffer[64];
+    char text[32];
+    bool ok = true;
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        const Range& range = ranges[r];
+        long checked = 0, parseErrors = 0, formatErrors = 0;
+        for (long k = -range.limit; k <= range.limit; k++) {
+            int length = widgetText(k, range.decimals, text);
+            TinkerIoTView view = { text, (uint16_t)length };
+
+            float parsed;
+            float expected = strtof(text, nullptr);
+            if (range.decimals == 0) {
+                long integer;
+                if (!view.toLong(integer) || integer != k) parseErrors++;
+                parsed = (float)k;
+            } else if (!view.toFloat(parsed) || memcmp(&parsed, &expected, sizeof(float)) != 0) {
+                parseErrors++;
+                if (verbose && parseErrors <= 3) printf("  parse %s -> %.9g (strtof %.9g)\n", text, parsed, expected);
+                continue;
+            }
+
+            TinkerIoTFrameWriter writer(buffer, sizeof(buffer));
+            writer.begin(HARDWARE, 0);
+            writer.putFixed(parsed, range.decimals);
+            const char* formatted = writer.textAt(TinkerIoTFrameWriter::HEADER_SIZE);
+            if (strcmp(formatted, text) != 0) {
+                formatErrors++;
+                if (verbose && formatErrors <= 3) printf("  format %s -> %s\n", text, formatted);
+            }
+            checked++;
+        }
+        if (verbose) {
+            widgetText(range.limit, range.decimals, text);
+            printf("%d decimals, |value| <= %s: %ld values, %ld parse / %ld format mismatches\n", range.decimals,
+                   text, checked, parseErrors, formatErrors);
+        }
+        ok = ok && parseErrors == 0 && formatErrors == 0;
+    }
+    return ok;
+}
+
+static const char* const samples[] = { "21.5", "-3.25", "100", "0.01", "1013.25", "-40.0", "7", "55.55" };
+static const size_t sampleCount = sizeof(samples) / sizeof(samples[0]);
+
+int main(int argc, char** argv) {
+    bool json = false;
+    for (int i = 1; i < argc; i++) json = json || strcmp(argv[i], "--json") == 0;
+    if (!roundTrip(!json)) {
+        fprintf(stderr, "round-trip check failed\n");
+        return 1;
+    }
+    if (!json) printf("\n");
+
+    bench::Suite suite("numbers");
+
+    suite.add("format int: putInt", [](uint64_t n) {
+        uint8_t buffer[32];
+        TinkerIoTFrameWriter writer(buffer, sizeof(buffer));
+        for (uint64_t i = 0; i < n; i++) {
+            writer.begin(HARDWARE, 0);
+            writer.putInt((long)(i * 7919) - 100000);
+            bench::keep(buffer);
+        }
+    });
+    suite.add("format int: String(int)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            String text((int)(i * 7919) - 100000);
+            bench::keep(text);
+        }
+    });
+    suite.add("format float: putFixed(2)", [](uint64_t n) {
+        uint8_t buffer[32];
+        TinkerIoTFrameWriter writer(buffer, sizeof(buffer));
+        for (uint64_t i = 0; i < n; i++) {
+            writer.begin(HARDWARE, 0);
+            writer.putFixed(21.5f + (i & 1023) * 0.25f, 2);
+            bench::keep(buffer);
+        }
+    });
+    suite.add("format float: String(float, 2)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            String text(21.5f + (i & 1023) * 0.25f, 2);
+            bench::keep(text);
+        }
+    });
+    suite.add("parse int: TinkerIoTView::toLong", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            TinkerIoTView view = { "-12345", 6 };
+            long value = 0;
+            view.toLong(value);
+            bench::keep(value);
+        }
+    });
+    suite.add("parse int: String::toInt", [](uint64_t n) {
+        String text("-12345");
+        for (uint64_t i = 0; i < n; i++) {
+            long value = text.toInt();
+            bench::keep(value);
+        }
+    });
+    suite.add("parse float: TinkerIoTView::toFloat", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            const char* sample = samples[i % sampleCount];
+            TinkerIoTView view = { sample, (uint16_t)strlen(sample) };
+            float value = 0;
+            view.toFloat(value);
+            bench::keep(value);
+        }
+    });
+    suite.add("parse float: String::toFloat", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            String text(samples[i % sampleCount]);  // Handlers get a fresh String per value
+            float value = text.toFloat();
+            bench::keep(value);
+        }
+    });
+    suite.add("parse float: strtod", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            float value = (float)strtod(samples[i % sampleCount], nullptr);
+            bench::keep(value);
+        }
+    });
+    return suite.run(argc, argv);
+}
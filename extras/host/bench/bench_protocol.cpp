@@ -0,0 +1,206 @@
+// Micro-benchmarks for the TinkerIoT protocol hot paths.
+//
+//   build/tinkeriot_bench                 table
+//   build/tinkeriot_bench --json          machine-readable, for release comparisons
+//   build/tinkeriot_bench --filter=cloudWrite --min-time=1
+//
+// The client runs logged in on the virtual clock; outgoing frames go to a
+// sink that only counts bytes. Debug output is compiled in as shipped but
+// Serial is discarded: the numbers include the connection prints'
+// formatting and whatever the default log level records, not the UART.
+#include <TinkerIoT.h>
+
+#include "bench.h"
+
+// Reaches the private send/receive paths (friend of TinkerIoTClass)
+struct TinkerIoTHostAccess {
+    static void handleMessage(uint8_t* data, size_t length) {
+        TinkerIoT.rxMicros = micros();  // As webSocketEvent() stamps it
+        TinkerIoT.handleTinkerIoTMessage(data, length);
+    }
+    static void sendMessage(uint8_t command, uint16_t msg_id, const uint8_t* body, uint16_t length) {
+        TinkerIoT.sendTinkerIoTMessage(command, msg_id, body, length);
+    }
+    static void sendMessage(uint8_t command, uint16_t msg_id, String body) { TinkerIoT.sendTinkerIoTMessage(command, msg_id, body); }
+    static void sendResponse(uint16_t msg_id, uint8_t status) { TinkerIoT.sendResponse(msg_id, status); }
+    // As if the server had accepted TINKERIOT_FEATURE_BINARY_VALUES at login
+    static void setBinaryValues(bool enabled) { TinkerIoT.binaryValues = enabled; }
+};
+
+static void countWire(const uint8_t*, size_t length, void*) {
+    bench::wireBytes += length;
+}
+
+TINKERIOT_WRITE(C0) {
+    bench::keep(value);
+}
+
+TINKERIOT_WRITE_INT(C1) {
+    bench::keep(value);
+}
+
+static void noop() {}
+
+// Log in over the in-memory link and step past the post-login grace period
+static void connectClient() {
+    TinkerIoTHost::useVirtualClock(true);
+    TinkerIoTHost::linkSetSink(countWire, nullptr);
+    TinkerIoT.begin("bench-token", "ssid", "password", "127.0.0.1", 8008);
+    for (int i = 0; i < 4; i++) TinkerIoT.run();
+
+    uint8_t loginOk[] = { RESPONSE, 0, 1, 0, 1, SUCCESS, 0 };
+    TinkerIoTHost::linkDeliver(loginOk, 6);
+    for (int i = 0; i < 4; i++) TinkerIoT.run();
+    TinkerIoTHost::advanceMillis(2000);
+}
+
+// Frame with a spare trailing NUL, as arduinoWebSockets hands them over
+struct InboundFrame {
+    uint8_t data[64];
+    size_t length;
+
+    InboundFrame(uint8_t command, uint16_t msg_id, const char* body, size_t bodyLength) {
+        data[0] = command;
+        data[1] = msg_id >> 8;
+        data[2] = msg_id & 0xFF;
+        data[3] = bodyLength >> 8;
+        data[4] = bodyLength & 0xFF;
+        memcpy(data + 5, body, bodyLength);
+        length = 5 + bodyLength;
+        data[length] = 0;
+    }
+};
+
+int main(int argc, char** argv) {
+    connectClient();
+
+    bench::Suite suite("protocol");
+
+    suite.add("cloudWrite(int)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, (int)i);
+    });
+    suite.add("cloudWrite(float)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, 21.5f + (i & 7));
+    });
+    suite.add("cloudWrite(double)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, 1013.25 + (i & 7));
+    });
+    suite.add("cloudWrite(const char*)", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, "ON");
+    });
+    suite.add("cloudWrite(String)", [](uint64_t n) {
+        String value("ON");
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, value);
+    });
+    suite.add("cloudWrite(int) binary", [](uint64_t n) {
+        TinkerIoTHostAccess::setBinaryValues(true);
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, (int)i);
+        TinkerIoTHostAccess::setBinaryValues(false);
+    });
+    suite.add("cloudWrite(float) binary", [](uint64_t n) {
+        TinkerIoTHostAccess::setBinaryValues(true);
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, 21.5f + (i & 7));
+        TinkerIoTHostAccess::setBinaryValues(false);
+    });
+    suite.add("cloudWrite(int) coalesced", [](uint64_t n) {
+        TinkerIoT.setCoalescing(true, 100);
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.cloudWrite(C3, (int)i);
+        TinkerIoT.setCoalescing(false);
+    });
+    suite.add("cloudWrite(int) x8 batched", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) {
+            TinkerIoT.beginBatch();
+            for (int pin = 0; pin < 8; pin++) TinkerIoT.cloudWrite(pin + 8, (int)i);
+            TinkerIoT.commitBatch();
+        }
+    });
+
+    suite.add("sendTinkerIoTMessage(raw 16B)", [](uint64_t n) {
+        static const uint8_t body[16] = { 'c', 'w', 0, '3', 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '1' };
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::sendMessage(HARDWARE, 0, body, sizeof(body));
+    });
+    suite.add("sendTinkerIoTMessage(String 16B)", [](uint64_t n) {
+        String body("cw");
+        body += '\0';
+        body += "3";
+        body += '\0';
+        body += "12345678901";
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::sendMessage(HARDWARE, 0, body);
+    });
+    suite.add("sendResponse", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::sendResponse((uint16_t)i, SUCCESS);
+    });
+
+    suite.add("inbound cw -> handler -> echo", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 7, "cw\0" "0\0" "128", 8);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+    suite.add("inbound cw -> typed int handler -> echo", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 7, "cw\0" "1\0" "128", 8);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+    suite.add("inbound binary cw -> int handler -> echo", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 7, "cw\0" "1\0" "\x01\0\0\0\x80", 10);
+        TinkerIoTHostAccess::setBinaryValues(true);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+        TinkerIoTHostAccess::setBinaryValues(false);
+    });
+    suite.add("inbound cw -> int handler, echo none", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 7, "cw\0" "1\0" "128", 8);
+        TinkerIoT.setEchoPolicy(C1, TINKERIOT_ECHO_NONE);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+        TinkerIoT.setEchoPolicy(C1, TINKERIOT_ECHO_ALWAYS);
+    });
+    suite.add("inbound cw -> int handler, echo coalesced", [](uint64_t n) {
+        // One echo for the lot, sent by the run() after the interval
+        InboundFrame frame(HARDWARE, 7, "cw\0" "1\0" "128", 8);
+        TinkerIoT.setEchoPolicy(C1, TINKERIOT_ECHO_COALESCED);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+        TinkerIoTHost::advanceMillis(TINKERIOT_ECHO_INTERVAL_MS);
+        TinkerIoT.run();
+        TinkerIoT.setEchoPolicy(C1, TINKERIOT_ECHO_ALWAYS);
+    });
+    suite.add("inbound cw x4 -> handlers -> echo", [](uint64_t n) {
+        // Four tuples in one frame: the echoes share one HARDWARE frame
+        InboundFrame frame(HARDWARE, 7, "cw\0" "1\0" "128\0" "cw\0" "1\0" "129\0" "cw\0" "0\0" "1\0" "cw\0" "1\0" "130",
+                           33);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+    suite.add("inbound cw (no handler)", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 7, "cw\0" "5\0" "128", 8);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+    suite.add("inbound cr -> response", [](uint64_t n) {
+        InboundFrame frame(HARDWARE, 8, "cr\0" "3", 4);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+    suite.add("inbound ping -> response", [](uint64_t n) {
+        InboundFrame frame(PING, 9, "", 0);
+        for (uint64_t i = 0; i < n; i++) TinkerIoTHostAccess::handleMessage(frame.data, frame.length);
+    });
+
+    suite.add("run() idle", [](uint64_t n) {
+        for (uint64_t i = 0; i < n; i++) TinkerIoT.run();
+    });
+    suite.add("run() draining 8 queued pings", [](uint64_t n) {
+        // Includes the link's copy of each frame (one allocation per frame)
+        InboundFrame frame(PING, 9, "", 0);
+        for (uint64_t i = 0; i < n; i++) {
+            for (int k = 0; k < 8; k++) TinkerIoTHost::linkDeliver(frame.data, frame.length);
+            TinkerIoT.run();
+        }
+    });
+
+    suite.add("TinkerIoTTimer::run (16 timers, none due)", [](uint64_t n) {
+        TinkerIoTTimer timer;
+        for (int t = 0; t < 16; t++) timer.setInterval(3600000UL, noop);
+        for (uint64_t i = 0; i < n; i++) timer.run();
+    });
+    suite.add("TinkerIoTTimer::run (16 timers, all due)", [](uint64_t n) {
+        TinkerIoTTimer timer;
+        for (int t = 0; t < 16; t++) timer.setInterval(0, noop);
+        for (uint64_t i = 0; i < n; i++) timer.run();
+    });
+
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,166 @@
+// TinkerIoTTimer: scheduling accuracy and run() cost.
+//
+//   build/tinkeriot_timer_bench                 jitter report, then run() cost table
+//   build/tinkeriot_timer_bench --json          run() cost only, machine-readable
+//
+// The jitter report simulates an hour of a sketch loop on the virtual
+// clock: every loop iteration costs 1-3 ms, and 2% of them stall for
+// 40-120 ms (a blocking TLS write, a slow sensor). Four periodic timers run
+// under the deadline scheduler and under the previous fixed-array scanner
+// (reproduced below as LegacyTimer). Reported per timer:
+//
+//   fires / expected   how many times it ran vs. hour / interval
+//   phase p50/p99/max  ms between a run and the latest point of the
+//                      original grid (start + k * interval) - 0 for a
+//                      perfectly timed run, drifts for a free-running one
+#include <TinkerIoT.h>
+
+#include "bench.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+// The scanner TinkerIoTTimer used before it became deadline-ordered
+class LegacyTimer {
+    struct TimerItem {
+        unsigned long interval;
+        unsigned long lastRun;
+        TinkerIoTTimerCallback callback;
+        bool enabled;
+    };
+    TimerItem timers[16];
+    int timerCount = 0;
+
+public:
+    int setInterval(unsigned long interval, TinkerIoTTimerCallback callback) {
+        if (timerCount >= 16) return -1;
+        timers[timerCount].interval = interval;
+        timers[timerCount].lastRun = millis();
+        timers[timerCount].callback = callback;
+        timers[timerCount].enabled = true;
+        return timerCount++;
+    }
+
+    void run() {
+        unsigned long currentTime = millis();
+        for (int i = 0; i < timerCount; i++) {
+            if (!timers[i].enabled) continue;
+            if (currentTime - timers[i].lastRun >= timers[i].interval) {
+                timers[i].lastRun = currentTime;
+                if (timers[i].callback) timers[i].callback();
+            }
+        }
+    }
+};
+
+// ===== JITTER SIMULATION =====
+
+static const unsigned long intervals[] = { 10, 100, 1000, 1500 };
+static const int timerKinds = sizeof(intervals) / sizeof(intervals[0]);
+static const unsigned long simulatedMs = 3600000UL;
+
+static unsigned long simStart;
+static std::vector<unsigned long> phase[timerKinds];
+
+template <int N> static void onFire() {
+    unsigned long sinceStart = millis() - simStart;
+    phase[N].push_back(sinceStart % intervals[N]);
+}
+
+static const TinkerIoTTimerCallback callbacks[timerKinds] = { onFire<0>, onFire<1>, onFire<2>, onFire<3> };
+
+static uint32_t rng = 2463534242u;
+static uint32_t nextRandom() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static unsigned long loopCost() {
+    if (nextRandom() % 100 < 2) return 40 + nextRandom() % 81;
+    return 1 + nextRandom() % 3;
+}
+
+template <typename Timer> static void simulate(const char* name) {
+    TinkerIoTHost::setMicros(1000000ULL);
+    rng = 2463534242u;
+    simStart = millis();
+    for (int i = 0; i < timerKinds; i++) phase[i].clear();
+
+    Timer timer;
+    for (int i = 0; i < timerKinds; i++) timer.setInterval(intervals[i], callbacks[i]);
+    while (millis() - simStart < simulatedMs) {
+        timer.run();
+        TinkerIoTHost::advanceMillis(loopCost());
+    }
+
+    for (int i = 0; i < timerKinds; i++) {
+        std::vector<unsigned long>& p = phase[i];
+        std::sort(p.begin(), p.end());
+        unsigned long expected = simulatedMs / intervals[i];
+        printf("%-10s %8lu %8zu %9lu %9.1f %9lu %9lu %9lu\n", name, intervals[i], p.size(), expected,
+               100.0 * p.size() / expected, p.empty() ? 0 : p[p.size() / 2],
+               p.empty() ? 0 : p[p.size() * 99 / 100], p.empty() ? 0 : p.back());
+    }
+}
+
+static void reportJitter() {
+    printf("simulated 1 h loop: 1-3 ms per iteration, 2%% stalls of 40-120 ms\n");
+    printf("%-10s %8s %8s %9s %9s %9s %9s %9s\n", "scheduler", "interval", "fires", "expected", "fires %",
+           "phase p50", "p99", "max");
+    simulate<LegacyTimer>("legacy");
+    simulate<TinkerIoTTimer>("deadline");
+    printf("\n");
+}
+
+// ===== RUN() COST =====
+
+static void noop() {}
+
+template <typename Timer> static void addIdle(bench::Suite& suite, const char* name, int count) {
+    suite.add(name, [count](uint64_t n) {
+        Timer timer;
+        for (int t = 0; t < count; t++) timer.setInterval(3600000UL, noop);
+        for (uint64_t i = 0; i < n; i++) timer.run();
+    });
+}
+
+template <typename Timer> static void addOneDue(bench::Suite& suite, const char* name, int count) {
+    // One timer due per run(): the clock moves 1 ms per call and the
+    // intervals are spread so that a different timer fires each time
+    suite.add(name, [count](uint64_t n) {
+        TinkerIoTHost::setMicros(0);
+        Timer timer;
+        for (int t = 0; t < count; t++) timer.setInterval((unsigned long)count, noop);
+        for (uint64_t i = 0; i < n; i++) {
+            TinkerIoTHost::advanceMillis(1);
+            timer.run();
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    TinkerIoTHost::useVirtualClock(true);
+
+    bool json = false;
+    for (int i = 1; i < argc; i++) json = json || strcmp(argv[i], "--json") == 0;
+    if (!json) reportJitter();
+
+    bench::Suite suite("timer");
+    addIdle<LegacyTimer>(suite, "legacy run (16 timers, none due)", 16);
+    addIdle<TinkerIoTTimer>(suite, "deadline run (16 timers, none due)", 16);
+    addIdle<TinkerIoTTimer>(suite, "deadline run (4096 timers, none due)", 4096);
+    addOneDue<LegacyTimer>(suite, "legacy run (16 timers, one due)", 16);
+    addOneDue<TinkerIoTTimer>(suite, "deadline run (16 timers, one due)", 16);
+    addOneDue<TinkerIoTTimer>(suite, "deadline run (4096 timers, one due)", 4096);
+    suite.add("setTimeout + fire (id reuse)", [](uint64_t n) {
+        TinkerIoTTimer timer;
+        for (uint64_t i = 0; i < n; i++) {
+            timer.setTimeout(0, noop);
+            timer.run();
+        }
+    });
+    return suite.run(argc, argv);
+}
@@ -0,0 +1,171 @@
+// Latency probe and handler timing against known distributions, on the
+// virtual clock.
+//
+//   build/tinkeriot_latency [--seconds=600] [--probe=1000] [--writes=10]
+//
+// The client sends a PING every --probe ms (setLatencyProbe()). The server
+// side answers each one after a delay drawn from a two-part distribution:
+// 95% between 20 and 60 ms, 5% between 300 and 900 ms. It also sends
+// --writes cw frames per second to C1, whose handler "works" for 200 to
+// 400 us, or 5 to 15 ms one time in ten, by advancing the clock. C9
+// carries the published summary (setLatencyReport()).
+//
+// The delays and run times actually drawn are kept, and their exact p50,
+// p99 and max are printed next to the client's histogram values. Exit
+// status 1 if a histogram percentile is below the exact one or more than
+// twice it (plus a millisecond, the clock's step), or if a probe was lost.
+#include <TinkerIoT.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Options {
+    unsigned seconds = 600;
+    unsigned long probe = 1000;
+    unsigned writes = 10;
+};
+
+static Options options;
+static uint32_t randomState = 2463534242u;
+
+static uint32_t next(uint32_t low, uint32_t high) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return low + randomState % (high - low + 1);
+}
+
+// Server side
+struct Answer {
+    unsigned long due;
+    uint8_t frame[6];
+};
+static std::vector<Answer> answers;
+static std::vector<uint32_t> rttDrawn;      // us
+static std::vector<uint32_t> workDrawn;     // us
+static char published[64];
+
+static void onDeviceFrame(const uint8_t* frame, size_t length, void*) {
+    if (frame[0] == LOGIN) {
+        uint8_t ok[] = { RESPONSE, frame[1], frame[2], 0, 1, SUCCESS };
+        TinkerIoTHost::linkDeliver(ok, sizeof(ok));
+        return;
+    }
+    if (frame[0] == PING) {
+        uint32_t delay = next(1, 100) <= 95 ? next(20, 60) : next(300, 900);
+        rttDrawn.push_back(delay * 1000);
+        Answer a = { millis() + delay, { RESPONSE, frame[1], frame[2], 0, 1, SUCCESS } };
+        answers.push_back(a);
+        return;
+    }
+    if (frame[0] != HARDWARE) return;
+    TinkerIoTFrameReader reader(frame + 5, length - 5);
+    TinkerIoTView command, pin, value;
+    while (reader.next(command) && reader.next(pin) && reader.next(value)) {
+        if (pin.equals("9") && value.length < sizeof(published)) {
+            memcpy(published, value.data, value.length);
+            published[value.length] = 0;
+        }
+    }
+}
+
+TINKERIOT_WRITE_INT(C1) {
+    uint32_t work = next(1, 10) == 1 ? next(5000, 15000) : next(200, 400);
+    workDrawn.push_back(work);
+    TinkerIoTHost::advanceMicros(work);
+}
+
+static uint32_t exact(std::vector<uint32_t> samples, unsigned percent) {
+    if (samples.empty()) return 0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = (samples.size() * percent + 99) / 100;
+    return samples[rank ? rank - 1 : 0];
+}
+
+// One row; false if the histogram is outside its factor-of-two bound
+static bool report(const char* name, const TinkerIoTHistogram& histogram, const std::vector<uint32_t>& drawn) {
+    static const unsigned percents[] = { 50, 99 };
+    bool ok = true;
+    printf("%-8s %8u", name, histogram.count);
+    for (size_t i = 0; i < 2; i++) {
+        uint32_t truth = exact(drawn, percents[i]);
+        uint32_t reported = histogram.percentile(percents[i]);
+        ok = ok && reported >= truth && reported <= 2 * truth + 1000;
+        printf(" %10u %10u", truth, reported);
+    }
+    printf(" %10u %10u\n", exact(drawn, 100), histogram.maxMicros);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = (unsigned)atoi(arg + 10);
+        } else if (strncmp(arg, "--probe=", 8) == 0) {
+            options.probe = (unsigned long)atol(arg + 8);
+        } else if (strncmp(arg, "--writes=", 9) == 0) {
+            options.writes = (unsigned)atoi(arg + 9);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds=600] [--probe=1000] [--writes=10]\n", argv[0]);
+            return 2;
+        }
+    }
+    // A probe must be answered before the next one goes out
+    if (options.seconds < 1 || options.probe <= 900 || options.writes < 1 || options.writes > 1000) return 2;
+
+    TinkerIoTHost::useVirtualClock(true);
+    TinkerIoTHost::linkSetSink(onDeviceFrame, nullptr);
+    TinkerIoT.begin("latency-token", "ssid", "password", "127.0.0.1", 8008);
+
+    // Log in and get past the post-login grace period
+    unsigned long start = millis();
+    while (millis() - start < 1500) {
+        TinkerIoT.run();
+        TinkerIoTHost::advanceMillis(1);
+    }
+    TinkerIoT.resetLatencyStats();
+    TinkerIoT.setLatencyProbe(options.probe);
+    TinkerIoT.setLatencyReport(C9, 10000);
+
+    unsigned long period = 1000 / options.writes;
+    unsigned long nextWrite = millis();
+    unsigned long end = millis() + options.seconds * 1000UL;
+    long seq = 0;
+    while ((long)(millis() - end) < 0) {
+        unsigned long now = millis();
+        if ((long)(now - nextWrite) >= 0) {
+            char body[24];
+            int length = snprintf(body, sizeof(body), "cw%c1%c%ld", 0, 0, seq++);
+            uint8_t frame[32] = { HARDWARE, 0, 0, 0, (uint8_t)length };
+            memcpy(frame + 5, body, length);
+            TinkerIoTHost::linkDeliver(frame, 5 + length);
+            nextWrite += period;
+        }
+        for (size_t i = 0; i < answers.size();) {
+            if ((long)(now - answers[i].due) >= 0) {
+                TinkerIoTHost::linkDeliver(answers[i].frame, sizeof(answers[i].frame));
+                answers.erase(answers.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        TinkerIoT.run();
+        TinkerIoTHost::advanceMillis(1);
+    }
+
+    const TinkerIoTLatencyStats& stats = TinkerIoT.getLatencyStats();
+    TinkerIoTHandlerTiming c1 = TinkerIoT.getHandlerTiming(C1);
+    printf("%u s, PING every %lu ms, %u cw/s to C1\n", options.seconds, options.probe, options.writes);
+    printf("%-8s %8s %10s %10s %10s %10s %10s %10s\n", "us", "samples", "p50", "hist p50", "p99", "hist p99", "max",
+           "hist max");
+    bool ok = report("rtt", stats.rtt, rttDrawn);
+    ok = report("handler", stats.handler, workDrawn) && ok;
+    printf("dispatch p99 %u us, C1 %u calls, mean %llu us, max %u us\n", stats.dispatch.percentile(99), c1.calls,
+           c1.calls ? (unsigned long long)(c1.totalMicros / c1.calls) : 0ULL, c1.maxMicros);
+    printf("probes %u, lost %u, C9 \"%s\"\n", stats.probes, stats.probesLost, published);
+    return ok && stats.probesLost == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// Store and forward across a link outage, on the virtual clock.
+//
+//   build/tinkeriot_offline [--rate=10] [--outage=30] [--ram=64] [--file=build/offline.q]
+//
+// A sensor writes an increasing sequence number to C3 at --rate Hz. Five
+// seconds after login the link drops for --outage seconds, then comes back
+// and the run continues until the backlog has been replayed. The server
+// side records every C3 value it receives. Three clients run the same
+// script: no buffer (the previous behaviour), RAM ring of --ram entries,
+// and the same ring spilling to a file. Reported per client:
+//
+//   lost        values written but never received
+//   reordered   values received after a larger one
+//   replay ms   from the reconnect until the backlog is empty
+//   peak f/s    most frames in any one second during the replay
+//
+// Exit status 1 if the file-backed client lost or reordered anything, 2 if
+// the --file path (relative to the current directory) cannot be created.
+#include <TinkerIoT.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+struct Options {
+    unsigned rate = 10;
+    unsigned outage = 30;
+    unsigned ram = 64;
+    const char* file = "build/offline.q";
+};
+
+// Server side: C3 values and frame arrival times
+static std::vector<long> received;
+static std::vector<unsigned long> frameTimes;
+
+static void onDeviceFrame(const uint8_t* frame, size_t length, void*) {
+    if (frame[0] == LOGIN) {
+        uint8_t ok[] = { RESPONSE, frame[1], frame[2], 0, 1, SUCCESS };
+        TinkerIoTHost::linkDeliver(ok, sizeof(ok));
+        return;
+    }
+    if (frame[0] != HARDWARE) return;
+    frameTimes.push_back(millis());
+
+    TinkerIoTFrameReader reader(frame + 5, length - 5);
+    TinkerIoTView command, pin, value;
+    while (reader.next(command) && reader.next(pin) && reader.next(value)) {
+        long number;
+        if (pin.equals("3") && value.toLong(number)) received.push_back(number);
+    }
+}
+
+struct Result {
+    long written;
+    long lost;
+    long reordered;
+    unsigned long replayMs;
+    size_t peakFrames;
+    TinkerIoTOfflineStats stats;
+};
+
+static Result runScript(TinkerIoTClass& client, const Options& options) {
+    received.clear();
+    frameTimes.clear();
+    TinkerIoTHost::linkSetAutoConnect(true);
+    client.begin("offline-token", "ssid", "password", "127.0.0.1", 8008);
+
+    long seq = 0;
+    unsigned long period = 1000 / options.rate;
+    unsigned long nextWrite = millis();
+    unsigned long reconnectAt = 0;
+    unsigned long replayDone = 0;
+    int phase = 0;                      // 0 online, 1 outage, 2 replaying, 3 done
+    unsigned long phaseEnd = millis() + 8000;
+
+    while (phase < 3) {
+        unsigned long now = millis();
+        if ((long)(now - nextWrite) >= 0) {
+            client.cloudWrite(C3, (int)seq++);
+            nextWrite += period;
+        }
+        if (phase == 0 && (long)(now - phaseEnd) >= 0) {
+            TinkerIoTHost::linkSetAutoConnect(false);
+            TinkerIoTHost::linkDisconnect();
+            phase = 1;
+            phaseEnd = now + options.outage * 1000UL;
+        } else if (phase == 1 && (long)(now - phaseEnd) >= 0) {
+            TinkerIoTHost::linkConnect();
+            reconnectAt = now;
+            phase = 2;
+            phaseEnd = now + 600000UL;  // Give up after ten minutes
+        } else if (phase == 2 && client.connected() && now - reconnectAt > 1000 &&
+                   client.getOfflineStats().depth == 0) {
+            replayDone = now;
+            phase = 3;
+        } else if (phase == 2 && (long)(now - phaseEnd) >= 0) {
+            phase = 3;
+        }
+
+        client.run();
+        TinkerIoTHost::advanceMillis(1);
+    }
+
+    Result result;
+    result.written = seq;
+    result.reordered = 0;
+    std::vector<bool> seen(seq, false);
+    long highest = -1;
+    for (size_t i = 0; i < received.size(); i++) {
+        long v = received[i];
+        if (v >= 0 && v < seq) seen[v] = true;
+        if (v < highest) result.reordered++;
+        if (v > highest) highest = v;
+    }
+    result.lost = 0;
+    for (long v = 0; v < seq; v++) result.lost += !seen[v];
+    result.replayMs = replayDone && client.getOfflineStats().buffered ? replayDone - reconnectAt : 0;
+
+    // Busiest one-second window from the reconnect on
+    result.peakFrames = 0;
+    for (size_t i = 0, j = 0; j < frameTimes.size(); j++) {
+        if (frameTimes[j] < reconnectAt) {
+            i = j + 1;
+            continue;
+        }
+        while (frameTimes[j] - frameTimes[i] >= 1000) i++;
+        if (j - i + 1 > result.peakFrames) result.peakFrames = j - i + 1;
+    }
+    result.stats = client.getOfflineStats();
+    return result;
+}
+
+static void report(const char* name, const Result& r) {
+    printf("%-12s %8ld %8ld %10ld %10lu %9zu %9u %9u\n", name, r.written, r.lost, r.reordered, r.replayMs,
+           r.peakFrames, r.stats.dropped, r.stats.replayed);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--rate=", 7) == 0) {
+            options.rate = (unsigned)atoi(arg + 7);
+        } else if (strncmp(arg, "--outage=", 9) == 0) {
+            options.outage = (unsigned)atoi(arg + 9);
+        } else if (strncmp(arg, "--ram=", 6) == 0) {
+            options.ram = (unsigned)atoi(arg + 6);
+        } else if (strncmp(arg, "--file=", 7) == 0) {
+            options.file = arg + 7;
+        } else {
+            fprintf(stderr, "usage: %s [--rate=10] [--outage=30] [--ram=64] [--file=build/offline.q]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (options.rate < 1 || options.rate > 1000 || options.ram < 1 || options.ram > 65535) return 2;
+
+    // The file store falls back to RAM only when it cannot open its file,
+    // which would make the last row a second "ram" row
+    FILE* probe = fopen(options.file, "wb");
+    if (!probe) {
+        fprintf(stderr, "cannot create %s: %s (run from extras/host or pass --file=)\n", options.file,
+                strerror(errno));
+        return 2;
+    }
+    fclose(probe);
+    remove(options.file);
+
+    TinkerIoTHost::useVirtualClock(true);
+    TinkerIoTHost::linkSetSink(onDeviceFrame, nullptr);
+
+    printf("%u values/s, %u s outage, %u RAM entries, replay %u values per %u ms\n", options.rate,
+           options.outage, options.ram, TINKERIOT_OFFLINE_REPLAY_BATCH, TINKERIOT_OFFLINE_REPLAY_INTERVAL_MS);
+    printf("%-12s %8s %8s %10s %10s %9s %9s %9s\n", "buffer", "written", "lost", "reordered", "replay ms",
+           "peak f/s", "dropped", "replayed");
+
+    TinkerIoTDefaultClient* none = new TinkerIoTDefaultClient;
+    report("none", runScript(*none, options));
+
+    TinkerIoTDefaultClient* ram = new TinkerIoTDefaultClient;
+    ram->enableOfflineBuffer(options.ram);
+    report("ram", runScript(*ram, options));
+
+    TinkerIoTFileStore store(options.file);
+    TinkerIoTDefaultClient* file = new TinkerIoTDefaultClient;
+    file->enableOfflineBuffer(options.ram, &store);
+    Result spilled = runScript(*file, options);
+    report("ram+file", spilled);
+
+    return spilled.lost == 0 && spilled.reordered == 0 ? 0 : 1;
+}
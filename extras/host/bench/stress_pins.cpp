@@ -0,0 +1,157 @@
+// Cloud pin table under concurrent readers and writers.
+//
+//   build/tinkeriot_pin_stress [--seconds=2] [--readers=2] [--writers=2] [--pins=4]
+//
+// Writers store text values through the library's storePin(), readers load
+// them back with loadPin(), all on the same few pins. Every value is
+// self-describing ("<k>|<k>|..." cut at a length derived from k), so a
+// reader can tell a torn copy - half of one write, half of another - from
+// a whole one. The same workload then runs against a table guarded by one
+// global mutex (the previous scheme, reproduced below) for comparison.
+// Exit status 1 if any torn value was observed.
+#include <TinkerIoT.h>
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+struct TinkerIoTHostAccess {
+    static void store(int pin, const char* text, size_t length) {
+        TinkerIoT.storePin(pin, TINKERIOT_VALUE_TEXT, text, length);
+    }
+    static void load(int pin, TinkerIoTPinValue& out) { TinkerIoT.loadPin(pin, out); }
+};
+
+// The pin table before it was versioned: one lock for every access
+class LockedTable {
+    TinkerIoTPinValue pins[32];
+    std::mutex lock;
+
+public:
+    LockedTable() { memset(pins, 0, sizeof(pins)); }
+
+    void store(int pin, const char* text, size_t length) {
+        std::lock_guard<std::mutex> guard(lock);
+        pins[pin].type = TINKERIOT_VALUE_TEXT;
+        pins[pin].length = length;
+        memcpy(pins[pin].text, text, length);
+        pins[pin].text[length] = '\0';
+    }
+    void load(int pin, TinkerIoTPinValue& out) {
+        std::lock_guard<std::mutex> guard(lock);
+        out = pins[pin];
+    }
+};
+
+struct Options {
+    double seconds = 2;
+    int readers = 2;
+    int writers = 2;
+    int pins = 4;
+};
+
+// Value number k: "k|k|k..." truncated to 8 + k % 24 characters
+static size_t encode(uint32_t k, char* out) {
+    char number[12];
+    int digits = snprintf(number, sizeof(number), "%u|", k);
+    size_t length = 8 + k % 24;
+    for (size_t i = 0; i < length; i++) out[i] = number[i % digits];
+    return length;
+}
+
+static bool whole(const TinkerIoTPinValue& value) {
+    if (value.type == TINKERIOT_VALUE_EMPTY) return true;  // Not written yet
+    if (value.type != TINKERIOT_VALUE_TEXT || value.length > TINKERIOT_MAX_VALUE_LEN) return false;
+    uint32_t k = (uint32_t)strtoul(value.text, nullptr, 10);
+    char expected[TINKERIOT_MAX_VALUE_LEN + 1];
+    size_t length = encode(k, expected);
+    return length == value.length && memcmp(expected, value.text, length) == 0 && value.text[length] == '\0';
+}
+
+struct Totals {
+    uint64_t writes;
+    uint64_t reads;
+    uint64_t torn;
+};
+
+template <typename Store, typename Load>
+static Totals stress(const Options& options, Store store, Load load) {
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> writes(0), reads(0), torn(0);
+    std::vector<std::thread> threads;
+
+    for (int w = 0; w < options.writers; w++) {
+        threads.push_back(std::thread([&, w] {
+            char text[TINKERIOT_MAX_VALUE_LEN];
+            uint64_t count = 0;
+            for (uint32_t k = (uint32_t)w * 1000003u; !stop.load(std::memory_order_relaxed); k++) {
+                store((int)(k % options.pins), text, encode(k, text));
+                count++;
+            }
+            writes += count;
+        }));
+    }
+    for (int r = 0; r < options.readers; r++) {
+        threads.push_back(std::thread([&, r] {
+            TinkerIoTPinValue value;
+            uint64_t count = 0, bad = 0;
+            for (uint32_t i = (uint32_t)r; !stop.load(std::memory_order_relaxed); i++) {
+                load((int)(i % options.pins), value);
+                if (!whole(value)) bad++;
+                count++;
+            }
+            reads += count;
+            torn += bad;
+        }));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds((long)(options.seconds * 1000)));
+    stop = true;
+    for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+
+    Totals totals = { writes.load(), reads.load(), torn.load() };
+    return totals;
+}
+
+static void report(const char* name, const Totals& totals, double seconds) {
+    printf("%-10s %14.0f %14.0f %10llu\n", name, totals.writes / seconds, totals.reads / seconds,
+           (unsigned long long)totals.torn);
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--seconds=", 10) == 0) {
+            options.seconds = atof(arg + 10);
+        } else if (strncmp(arg, "--readers=", 10) == 0) {
+            options.readers = atoi(arg + 10);
+        } else if (strncmp(arg, "--writers=", 10) == 0) {
+            options.writers = atoi(arg + 10);
+        } else if (strncmp(arg, "--pins=", 7) == 0) {
+            options.pins = atoi(arg + 7);
+        } else {
+            fprintf(stderr, "usage: %s [--seconds=2] [--readers=2] [--writers=2] [--pins=4]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (options.pins < 1 || options.pins > 32 || options.readers < 0 || options.writers < 0) return 2;
+
+    printf("%d writers, %d readers, %d pins, %.1f s each, %u hardware threads\n", options.writers,
+           options.readers, options.pins, options.seconds, std::thread::hardware_concurrency());
+    printf("%-10s %14s %14s %10s\n", "table", "writes/s", "reads/s", "torn");
+
+    Totals versioned = stress(options, TinkerIoTHostAccess::store, TinkerIoTHostAccess::load);
+    report("seqlock", versioned, options.seconds);
+
+    LockedTable table;
+    Totals locked = stress(
+        options, [&table](int pin, const char* text, size_t length) { table.store(pin, text, length); },
+        [&table](int pin, TinkerIoTPinValue& out) { table.load(pin, out); });
+    report("mutex", locked, options.seconds);
+
+    return versioned.torn == 0 && locked.torn == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Scripted TinkerIoT session on the host build.
+//
+// Plays the server side over the in-memory link on the virtual clock:
+// accepts the login (the client connects from run(), begin() returns at
+// once), pushes a cw to C0 and C1, reads C3 back and pings, while the
+// sketch part writes telemetry from a TinkerIoTTimer. Every frame in both
+// directions is printed, so this doubles as a quick protocol trace, and
+// the runtime counters and the deferred log are read back at the end.
+#include <TinkerIoT.h>
+
+#include <stdio.h>
+
+static void printFrame(const char* direction, const uint8_t* frame, size_t length) {
+    printf("%8lu ms %s cmd=%-2u id=%-3u len=%-3u ", millis(), direction,
+           frame[0], (frame[1] << 8) | frame[2], (frame[3] << 8) | frame[4]);
+    if (frame[0] == RESPONSE && length > 5) {
+        printf("status=%u\n", frame[5]);
+        return;
+    }
+    for (size_t i = 5; i < length; i++) {
+        putchar(frame[i] ? frame[i] : '|');
+    }
+    putchar('\n');
+}
+
+static void serverSend(uint8_t command, uint16_t msg_id, const char* body, size_t bodyLength);
+
+static void onDeviceFrame(const uint8_t* frame, size_t length, void*) {
+    printFrame("dev->srv", frame, length);
+    if (frame[0] == LOGIN) {
+        const char ok[] = { (char)SUCCESS };
+        serverSend(RESPONSE, (frame[1] << 8) | frame[2], ok, sizeof(ok));  // Accept the login
+    }
+}
+
+static void serverSend(uint8_t command, uint16_t msg_id, const char* body, size_t bodyLength) {
+    uint8_t frame[64];
+    frame[0] = command;
+    frame[1] = msg_id >> 8;
+    frame[2] = msg_id & 0xFF;
+    frame[3] = bodyLength >> 8;
+    frame[4] = bodyLength & 0xFF;
+    memcpy(frame + 5, body, bodyLength);
+    printFrame("srv->dev", frame, 5 + bodyLength);
+    TinkerIoTHost::linkDeliver(frame, 5 + bodyLength);
+}
+
+static int ledState = 0;
+
+TINKERIOT_WRITE(C0) {
+    ledState = param.asInt();
+    printf("           handler C0 <- %s\n", value.c_str());
+}
+
+static float setpoint = 0;
+
+TINKERIOT_WRITE_FLOAT(C1) {
+    setpoint = value;
+    printf("           handler C1 <- %.2f\n", value);
+}
+
+static TinkerIoTTimer timer;
+static int sample = 0;
+
+static void sendTelemetry() {
+    TinkerIoT.cloudWrite(C3, 20.0f + (sample++ % 10) * 0.25f);
+}
+
+static void runFor(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += 10) {
+        TinkerIoT.run();
+        timer.run();
+        TinkerIoTHost::advanceMillis(10);
+    }
+}
+
+int main() {
+    TinkerIoTHost::useVirtualClock(true);
+    TinkerIoTHost::setWiFiConnectDelay(300);
+    TinkerIoTHost::linkSetSink(onDeviceFrame, nullptr);
+
+    TinkerIoT.setLogOutput(nullptr);                // Keep the records for the end
+    TinkerIoT.begin("demo-token", "ssid", "password", "127.0.0.1", 8008);
+    timer.setInterval(1000, sendTelemetry);
+
+    runFor(2500);                                   // WiFi, socket, login, grace period
+    const TinkerIoTConnectTimes& times = TinkerIoT.connectionTimes();
+    printf("           connected in %lu ms (WiFi %lu, WebSocket %lu, login %lu)\n",
+           times.total, times.wifi, times.webSocket, times.login);
+
+    serverSend(HARDWARE, 2, "cw\0" "0\0" "1", 6);   // App switches C0 on
+    runFor(100);
+    serverSend(HARDWARE, 5, "cw\0" "1\0" "21.5", 9);  // Typed handler on C1
+    runFor(100);
+    serverSend(HARDWARE, 3, "cr\0" "3", 4);         // App reads C3
+    runFor(100);
+    serverSend(PING, 4, "", 0);
+    runFor(1500);
+
+    printf("C0 state: %d, C1 setpoint: %.2f\n", ledState, setpoint);
+
+    // The access point goes away; the client starts the association again
+    TinkerIoTHost::wifiDrop();
+    runFor(TINKERIOT_WIFI_RETRY_MS + 1000);
+    TinkerIoTHost::linkConnect();                   // The server takes the new socket
+    runFor(2500);
+    bool reconnected = WiFi.status() == WL_CONNECTED && TinkerIoT.state() == TINKERIOT_READY;
+    printf("           WiFi dropped: %s\n", reconnected ? "reconnected" : "still offline");
+
+    // What a fleet collector would get: the compact export, read back
+    uint8_t packed[TINKERIOT_STATS_EXPORT_MAX];
+    size_t packedLength = TinkerIoT.exportStats(packed, sizeof(packed));
+    TinkerIoTStats stats;
+    if (!tinkerIoTImportStats(packed, packedLength, stats)) return 1;
+    TinkerIoTTraffic in = {0, 0}, out = {0, 0};
+    for (int command = 0; command < TINKERIOT_STATS_COMMANDS; command++) {
+        in.frames += stats.in[command].frames;
+        in.bytes += stats.in[command].bytes;
+        out.frames += stats.out[command].frames;
+        out.bytes += stats.out[command].bytes;
+    }
+    printf("stats (%zu bytes exported): in %u frames / %u B, out %u frames / %u B, %u handler runs\n",
+           packedLength, in.frames, in.bytes, out.frames, out.bytes, stats.handlerCalls);
+
+    // The deferred log, decoded off the device: its newest records
+    #if TINKERIOT_LOG_LEVEL > 0
+    TinkerIoTLogRecord records[TINKERIOT_LOG_RECORDS];
+    uint16_t count = TinkerIoT.readLog(records, TINKERIOT_LOG_RECORDS);
+    printf("log: %u records kept, %u overwritten; the last ones:\n", count, TinkerIoT.getLogLost());
+    for (uint16_t i = count > 4 ? count - 4 : 0; i < count; i++) {
+        char line[96];
+        tinkerIoTFormatLog(records[i], line, sizeof(line));
+        printf("           %s\n", line);
+    }
+    #endif
+    return ledState == 1 && setpoint == 21.5f && reconnected ? 0 : 1;
+}
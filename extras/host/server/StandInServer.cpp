@@ -0,0 +1,325 @@
+#include "StandInServer.h"
+
+#include <TinkerIoT.h>
+
+#include "HostWebSocket.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+StandInServer::StandInServer() {}
+
+StandInServer::~StandInServer() {
+    for (std::map<int, Connection>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        close(it->second.fd);
+    }
+    closeListener();
+}
+
+bool StandInServer::listen(uint16_t port, const char* address) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address, &addr.sin_addr) != 1 ||
+        bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd, 128) != 0) {
+        close(fd);
+        return false;
+    }
+
+    socklen_t addrLength = sizeof(addr);
+    getsockname(fd, (struct sockaddr*)&addr, &addrLength);
+    _port = ntohs(addr.sin_port);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    _listenFd = fd;
+    return true;
+}
+
+void StandInServer::closeListener() {
+    if (_listenFd >= 0) {
+        close(_listenFd);
+        _listenFd = -1;
+    }
+}
+
+int StandInServer::poll(int timeoutMs) {
+    std::vector<struct pollfd> fds;
+    std::vector<int> ids;
+    if (_listenFd >= 0) {
+        struct pollfd pfd = { _listenFd, POLLIN, 0 };
+        fds.push_back(pfd);
+        ids.push_back(0);
+    }
+    for (std::map<int, Connection>::iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        struct pollfd pfd = { it->second.fd, POLLIN, 0 };
+        fds.push_back(pfd);
+        ids.push_back(it->first);
+    }
+
+    if (::poll(fds.data(), fds.size(), timeoutMs) <= 0) return 0;
+
+    int frames = 0;
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (!fds[i].revents) continue;
+        if (ids[i] == 0) {
+            accept();
+            continue;
+        }
+        std::map<int, Connection>::iterator it = _clients.find(ids[i]);
+        if (it == _clients.end()) continue;
+        if (!readable(it->first, it->second, frames)) drop(ids[i]);
+    }
+    return frames;
+}
+
+void StandInServer::accept() {
+    for (;;) {
+        int fd = ::accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) return;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        Connection& conn = _clients[_nextClient++];
+        conn.fd = fd;
+    }
+}
+
+void StandInServer::drop(int client) {
+    std::map<int, Connection>::iterator it = _clients.find(client);
+    if (it == _clients.end()) return;
+    bool wasLoggedIn = it->second.loggedIn;
+    close(it->second.fd);
+    _clients.erase(it);
+    if (_verbose) printf("[%d] disconnected\n", client);
+    if (wasLoggedIn && _onDisconnect) _onDisconnect(client);
+}
+
+// Read what is there and handle every complete frame. False closes the client.
+bool StandInServer::readable(int client, Connection& conn, int& frames) {
+    uint8_t chunk[4096];
+    ssize_t n = recv(conn.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    conn.rx.insert(conn.rx.end(), chunk, chunk + n);
+
+    if (!conn.open) {
+        if (!handshake(client, conn)) return false;
+        if (!conn.open) return true;
+    }
+
+    size_t offset = 0;
+    HostWebSocket::Frame frame;
+    for (;;) {
+        long used = HostWebSocket::decodeFrame(conn.rx.data() + offset, conn.rx.size() - offset, frame);
+        if (used < 0) return false;
+        if (used == 0) break;
+        offset += (size_t)used;
+
+        switch (frame.opcode) {
+            case HostWebSocket::OP_BINARY:
+                frames++;
+                handleFrame(client, conn, frame.payload.data(), frame.length);
+                if (_clients.find(client) == _clients.end()) return true;  // Dropped by a callback
+                break;
+            case HostWebSocket::OP_PING:
+                sendRaw(conn, HostWebSocket::OP_PONG, frame.payload.data(), frame.length);
+                break;
+            case HostWebSocket::OP_CLOSE:
+                sendRaw(conn, HostWebSocket::OP_CLOSE, nullptr, 0);
+                return false;
+            default:
+                break;
+        }
+    }
+    conn.rx.erase(conn.rx.begin(), conn.rx.begin() + offset);
+    return true;
+}
+
+bool StandInServer::handshake(int client, Connection& conn) {
+    std::string head(conn.rx.begin(), conn.rx.end());
+    size_t end = head.find("\r\n\r\n");
+    if (end == std::string::npos) return head.size() < 8192;
+    head.resize(end + 2);
+    conn.rx.erase(conn.rx.begin(), conn.rx.begin() + end + 4);
+
+    // GET /hardware/<token> HTTP/1.1
+    if (head.compare(0, 4, "GET ") != 0) return false;
+    size_t pathEnd = head.find(' ', 4);
+    if (pathEnd == std::string::npos) return false;
+    std::string path = head.substr(4, pathEnd - 4);
+    if (path.compare(0, 10, "/hardware/") == 0) conn.token = path.substr(10);
+
+    std::string key = HostWebSocket::headerValue(head, "Sec-WebSocket-Key");
+    if (key.empty()) return false;
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " + HostWebSocket::acceptKey(key) + "\r\n";
+    std::string protocol = HostWebSocket::headerValue(head, "Sec-WebSocket-Protocol");
+    if (!protocol.empty()) response += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+    response += "\r\n";
+    if (!HostWebSocket::sendAll(conn.fd, (const uint8_t*)response.data(), response.size())) return false;
+
+    conn.open = true;
+    if (_verbose) printf("[%d] websocket open %s\n", client, path.c_str());
+    return true;
+}
+
+void StandInServer::handleFrame(int client, Connection& conn, const uint8_t* frame, size_t length) {
+    if (_verbose) printf("[%d] dev->srv %s\n", client, describe(frame, length).c_str());
+    if (length < 5) return;
+
+    uint8_t command = frame[0];
+    uint16_t msg_id = (frame[1] << 8) | frame[2];
+
+    if (command == LOGIN) {
+        bool accepted = _token.empty() || conn.token == _token;
+        uint8_t reply[2] = { (uint8_t)(accepted ? SUCCESS : INVALID_TOKEN), 0 };
+        size_t replyLength = 1;
+        TinkerIoTFrameReader reader(frame + 5, length - 5);
+        TinkerIoTView key, mask;
+        long requested = 0;
+        if (reader.next(key) && key.equals("fe") && reader.next(mask) && mask.toLong(requested)) {
+            conn.features = accepted ? (uint8_t)requested & _features : 0;
+            reply[1] = conn.features;
+            replyLength = 2;
+        }
+        send(client, RESPONSE, msg_id, reply, replyLength);
+        if (accepted && !conn.loggedIn) {
+            conn.loggedIn = true;
+            if (_onLogin) _onLogin(client);
+        }
+    } else if (command == PING) {
+        uint8_t status = SUCCESS;
+        send(client, RESPONSE, msg_id, &status, 1);
+    } else if (command == HARDWARE && conn.loggedIn) {
+        uint8_t status = SUCCESS;
+        if (_quota) {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            uint64_t second = (uint64_t)ts.tv_sec;
+            if (second != conn.quotaSecond) {
+                conn.quotaSecond = second;
+                conn.quotaUsed = 0;
+            }
+            if (++conn.quotaUsed > _quota) status = QUOTA_LIMIT;
+        }
+        if (msg_id != 0 || status != SUCCESS) send(client, RESPONSE, msg_id, &status, 1);
+        if (status != SUCCESS) return;
+    }
+
+    if (_onFrame) _onFrame(client, frame, length);
+}
+
+bool StandInServer::send(int client, uint8_t command, uint16_t msg_id, const uint8_t* body, size_t length) {
+    std::map<int, Connection>::iterator it = _clients.find(client);
+    if (it == _clients.end() || !it->second.open) return false;
+
+    uint8_t header[5] = { command, (uint8_t)(msg_id >> 8), (uint8_t)msg_id, (uint8_t)(length >> 8), (uint8_t)length };
+    std::vector<uint8_t> frame(header, header + 5);
+    frame.insert(frame.end(), body, body + length);
+    if (_verbose) printf("[%d] srv->dev %s\n", client, describe(frame.data(), frame.size()).c_str());
+    return sendRaw(it->second, HostWebSocket::OP_BINARY, frame.data(), frame.size());
+}
+
+bool StandInServer::sendRaw(Connection& conn, uint8_t opcode, const uint8_t* payload, size_t length) {
+    conn.tx.clear();
+    HostWebSocket::encodeFrame(conn.tx, opcode, payload, length, false);
+    return HostWebSocket::sendAll(conn.fd, conn.tx.data(), conn.tx.size());
+}
+
+uint16_t StandInServer::nextMsgId(int client) {
+    std::map<int, Connection>::iterator it = _clients.find(client);
+    if (it == _clients.end()) return 0;
+    if (++it->second.msgId == 0) it->second.msgId = 1;
+    return it->second.msgId;
+}
+
+std::vector<int> StandInServer::loggedInClients() const {
+    std::vector<int> ids;
+    for (std::map<int, Connection>::const_iterator it = _clients.begin(); it != _clients.end(); ++it) {
+        if (it->second.loggedIn) ids.push_back(it->first);
+    }
+    return ids;
+}
+
+size_t StandInServer::loggedInCount() const {
+    return loggedInClients().size();
+}
+
+const std::string& StandInServer::token(int client) const {
+    static const std::string none;
+    std::map<int, Connection>::const_iterator it = _clients.find(client);
+    return it == _clients.end() ? none : it->second.token;
+}
+
+uint8_t StandInServer::features(int client) const {
+    std::map<int, Connection>::const_iterator it = _clients.find(client);
+    return it == _clients.end() ? 0 : it->second.features;
+}
+
+// Render a HARDWARE body tuple by tuple, so tagged values are decoded
+static void describeHardware(std::string& out, const uint8_t* body, size_t length) {
+    TinkerIoTFrameReader reader(body, length);
+    TinkerIoTView field;
+    uint8_t tag;
+    char text[32];
+    bool first = true;
+    while (reader.next(field)) {
+        bool write = field.equals("cw");
+        if (!first) out += '|';
+        first = false;
+        out.append(field.data, field.length);
+        if (!reader.next(field)) break;
+        out += '|';
+        out.append(field.data, field.length);
+        if (!write || !reader.nextValue(field, tag, true)) continue;
+        out += '|';
+        if (tag == TINKERIOT_TAG_INT32) {
+            snprintf(text, sizeof(text), "i:%d", (int32_t)field.toWord());
+        } else if (tag == TINKERIOT_TAG_FLOAT32) {
+            uint32_t bits = field.toWord();
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            snprintf(text, sizeof(text), "f:%g", value);
+        } else if (tag == TINKERIOT_TAG_RAW) {
+            snprintf(text, sizeof(text), "raw[%u]", field.length);
+        } else {
+            out.append(field.data, field.length);
+            continue;
+        }
+        out += text;
+    }
+}
+
+std::string StandInServer::describe(const uint8_t* frame, size_t length) {
+    if (length < 5) return "short frame";
+    char head[48];
+    snprintf(head, sizeof(head), "cmd=%-2u id=%-5u len=%-3u ", frame[0], (frame[1] << 8) | frame[2],
+             (frame[3] << 8) | frame[4]);
+    std::string out(head);
+    if (frame[0] == RESPONSE && length > 5) {
+        snprintf(head, sizeof(head), length > 6 ? "status=%u features=%u" : "status=%u", frame[5],
+                 length > 6 ? frame[6] : 0);
+        return out + head;
+    }
+    if (frame[0] == HARDWARE) {
+        describeHardware(out, frame + 5, length - 5);
+        return out;
+    }
+    for (size_t i = 5; i < length; i++) out += frame[i] ? (char)frame[i] : '|';
+    return out;
+}
@@ -0,0 +1,99 @@
+// Minimal stand-in for the TinkerIoT server, for local end-to-end runs.
+//
+// Speaks plain ws:// on a TCP port and the binary TinkerIoT protocol on
+// top: answers LOGIN (token taken from the /hardware/<token> URL) and PING
+// with RESPONSE, accepts the LOGIN feature request ("fe\0<mask>", see
+// TINKERIOT_FEATURE_BINARY_VALUES), answers device HARDWARE frames that
+// carry a message id (see setAckWindow()), and hands every device frame to
+// the onFrame callback so a test program can play the dashboard side.
+// Single-threaded; drive it by calling poll().
+#ifndef TINKERIOT_STANDIN_SERVER_H
+#define TINKERIOT_STANDIN_SERVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+class StandInServer {
+public:
+    typedef std::function<void(int client, const uint8_t* frame, size_t length)> FrameHandler;
+    typedef std::function<void(int client)> ClientHandler;
+
+    StandInServer();
+    ~StandInServer();
+
+    // Bind and listen; port 0 picks a free port (see port())
+    bool listen(uint16_t port, const char* address = "127.0.0.1");
+    uint16_t port() const { return _port; }
+    void closeListener();
+
+    // Accept, read and dispatch for up to timeoutMs. Returns frames handled.
+    int poll(int timeoutMs);
+
+    // Only accept this token at LOGIN (default: any token)
+    void setToken(const char* token) { _token = token ? token : ""; }
+    // Features granted to devices that ask for them at LOGIN (default: all)
+    void setFeatures(uint8_t mask) { _features = mask; }
+    // Refuse device HARDWARE frames past this many per second per client
+    // with QUOTA_LIMIT (0 = no quota); refused frames skip onFrame
+    void setQuota(unsigned framesPerSecond) { _quota = framesPerSecond; }
+    // Print every frame in both directions to stdout
+    void setVerbose(bool verbose) { _verbose = verbose; }
+
+    void onLogin(ClientHandler handler) { _onLogin = handler; }
+    void onDisconnect(ClientHandler handler) { _onDisconnect = handler; }
+    void onFrame(FrameHandler handler) { _onFrame = handler; }
+
+    // Send a TinkerIoT frame (header built here) to one client
+    bool send(int client, uint8_t command, uint16_t msg_id, const uint8_t* body, size_t length);
+    // Next server-side message id for a client (never 0)
+    uint16_t nextMsgId(int client);
+
+    std::vector<int> loggedInClients() const;
+    size_t loggedInCount() const;
+    const std::string& token(int client) const;
+    // Features accepted for a client's session (0 for an ASCII-only device)
+    uint8_t features(int client) const;
+    void drop(int client);
+
+    // "cmd=20 id=7 len=8 cw|0|42" style one-liner for logs; binary values
+    // show as i:42, f:21.5 or raw[n]
+    static std::string describe(const uint8_t* frame, size_t length);
+
+private:
+    struct Connection {
+        int fd = -1;
+        bool open = false;
+        bool loggedIn = false;
+        std::string token;
+        uint8_t features = 0;
+        std::vector<uint8_t> rx;
+        std::vector<uint8_t> tx;
+        uint16_t msgId = 0;
+        uint64_t quotaSecond = 0;       // Current one-second quota window
+        unsigned quotaUsed = 0;
+    };
+
+    void accept();
+    bool readable(int client, Connection& conn, int& frames);
+    bool handshake(int client, Connection& conn);
+    void handleFrame(int client, Connection& conn, const uint8_t* frame, size_t length);
+    bool sendRaw(Connection& conn, uint8_t opcode, const uint8_t* payload, size_t length);
+
+    int _listenFd = -1;
+    uint16_t _port = 0;
+    int _nextClient = 1;
+    std::map<int, Connection> _clients;
+    std::string _token;
+    uint8_t _features = 0xFF;
+    unsigned _quota = 0;
+    bool _verbose = false;
+    FrameHandler _onFrame;
+    ClientHandler _onLogin;
+    ClientHandler _onDisconnect;
+};
+
+#endif // TINKERIOT_STANDIN_SERVER_H
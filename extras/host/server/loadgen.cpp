@@ -0,0 +1,355 @@
+// tinkeriot_loadgen: end-to-end latency harness.
+//
+//   build/tinkeriot_loadgen [--clients=1] [--duration=5] [--warmup=1]
+//                           [--rate=0] [--ping=0] [--handler-us=0]
+//                           [--net-task] [--binary] [--json]
+//
+// Runs the stand-in server in this process and forks --clients host
+// TinkerIoT clients that connect to it over real WebSocket/TCP on loopback,
+// on the real clock. Each client has a TINKERIOT_WRITE(C0) handler, so a
+// "cw C0 <seq>" from the server comes back as the client's echo. Measured
+// per round trip, from the server's send:
+//
+//   echo   until the device's cw C0 <seq> echo arrives (command -> handler -> echo)
+//   ack    until the device's RESPONSE for the same msg id
+//   ping   PING -> RESPONSE, every --ping ms per client (0 = off)
+//
+// --rate=0 runs closed loop (next cw as soon as the echo is back);
+// --rate=N sends N cw/s per client open loop. Prints p50/p90/p99/p99.9/max
+// and the sustained round trips and frames per second.
+//
+// --handler-us=N makes the C0 handler busy-wait N us, like a sketch doing
+// real work in it. --net-task runs the clients with startNetworkTask(), so
+// PING replies come from the network thread and no longer queue behind the
+// handler: compare the ping row with and without it.
+//
+// --binary has the clients negotiate binary values at LOGIN: the cw goes
+// out as a tagged int32 and the echo comes back as one. Compare bytes/s.
+#include "StandInServer.h"
+
+#include <TinkerIoT.h>
+
+#include <algorithm>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// ===== DEVICE SIDE (forked children) =====
+
+static unsigned handlerMicros = 0;
+static bool useNetworkTask = false;
+static bool useBinaryValues = false;
+
+TINKERIOT_WRITE(C0) {
+    // The library echoes C0 back after the handler returns
+    unsigned long start = micros();
+    while (micros() - start < handlerMicros) {
+    }
+}
+
+static void runClient(uint16_t port, int index) {
+    TinkerIoTHost::useVirtualClock(false);
+    TinkerIoTHost::useTcpTransport(true);
+
+    char token[32];
+    snprintf(token, sizeof(token), "loadgen-%d", index);
+    TinkerIoT.setBinaryValues(useBinaryValues);
+    TinkerIoT.begin(token, "ssid", "password", "127.0.0.1", port);
+    if (useNetworkTask) TinkerIoT.startNetworkTask();
+
+    pid_t parent = getppid();
+    while (getppid() == parent) {
+        TinkerIoT.run();
+        TinkerIoT.waitForEvent(100);
+    }
+}
+
+// ===== SERVER SIDE =====
+
+static uint64_t nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+struct Series {
+    const char* name;
+    std::vector<uint32_t> samples;
+
+    explicit Series(const char* n) : name(n) {}
+
+    double percentile(double p) const {
+        if (samples.empty()) return 0;
+        size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[index];
+    }
+};
+
+// One in-flight request, indexed by msg id
+struct Pending {
+    uint16_t msg_id = 0;
+    uint64_t sentAt = 0;
+    bool isPing = false;
+    bool active = false;
+};
+
+// One cw awaiting its echo, indexed by seq
+struct Outstanding {
+    uint32_t seq = 0;
+    uint64_t sentAt = 0;
+    bool active = false;
+};
+
+struct ClientState {
+    uint32_t seq = 0;
+    unsigned inFlight = 0;
+    uint64_t lastSend = 0;
+    Outstanding echoes[1024];       // seq & 1023
+    uint64_t nextSend = 0;
+    uint64_t nextPing = 0;
+    Pending pending[256];           // msg_id & 255
+};
+
+struct Options {
+    int clients = 1;
+    double duration = 5;
+    double warmup = 1;
+    double rate = 0;
+    unsigned pingMs = 0;
+    unsigned handlerUs = 0;
+    bool netTask = false;
+    bool binary = false;
+    bool json = false;
+};
+
+static void printSeries(const Series& s, bool json, bool last) {
+    if (json) {
+        printf("    \"%s\": {\"count\": %zu, \"p50_us\": %.0f, \"p90_us\": %.0f, \"p99_us\": %.0f, "
+               "\"p999_us\": %.0f, \"max_us\": %.0f}%s\n",
+               s.name, s.samples.size(), s.percentile(50), s.percentile(90), s.percentile(99),
+               s.percentile(99.9), s.percentile(100), last ? "" : ",");
+        return;
+    }
+    printf("%-6s %10zu %10.0f %10.0f %10.0f %10.0f %10.0f\n", s.name, s.samples.size(), s.percentile(50),
+           s.percentile(90), s.percentile(99), s.percentile(99.9), s.percentile(100));
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strncmp(arg, "--clients=", 10) == 0) {
+            options.clients = atoi(arg + 10);
+        } else if (strncmp(arg, "--duration=", 11) == 0) {
+            options.duration = atof(arg + 11);
+        } else if (strncmp(arg, "--warmup=", 9) == 0) {
+            options.warmup = atof(arg + 9);
+        } else if (strncmp(arg, "--rate=", 7) == 0) {
+            options.rate = atof(arg + 7);
+        } else if (strncmp(arg, "--ping=", 7) == 0) {
+            options.pingMs = (unsigned)atoi(arg + 7);
+        } else if (strncmp(arg, "--handler-us=", 13) == 0) {
+            options.handlerUs = (unsigned)atoi(arg + 13);
+        } else if (strcmp(arg, "--net-task") == 0) {
+            options.netTask = true;
+        } else if (strcmp(arg, "--binary") == 0) {
+            options.binary = true;
+        } else if (strcmp(arg, "--json") == 0) {
+            options.json = true;
+        } else {
+            return false;
+        }
+    }
+    return options.clients > 0 && options.duration > 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--clients=1] [--duration=5] [--warmup=1] [--rate=0] [--ping=0] [--handler-us=0] [--net-task] [--binary] [--json]\n",
+                argv[0]);
+        return 2;
+    }
+
+    StandInServer server;
+    if (!server.listen(0)) {
+        perror("listen");
+        return 1;
+    }
+
+    // Fork before the server does anything else; children never touch it
+    handlerMicros = options.handlerUs;
+    useNetworkTask = options.netTask;
+    useBinaryValues = options.binary;
+    std::vector<pid_t> children;
+    for (int i = 0; i < options.clients; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            server.closeListener();
+            runClient(server.port(), i);
+            _exit(0);
+        }
+        if (pid < 0) {
+            perror("fork");
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    std::map<int, ClientState> states;
+    Series echo("echo"), ack("ack"), ping("ping");
+    uint64_t framesIn = 0, framesOut = 0, bytesIn = 0, bytesOut = 0, roundTrips = 0;
+    bool measuring = false;
+
+    server.onFrame([&](int client, const uint8_t* frame, size_t length) {
+        uint64_t now = nowMicros();
+        ClientState& state = states[client];
+        if (measuring) {
+            framesIn++;
+            bytesIn += length;
+        }
+        uint16_t msg_id = (frame[1] << 8) | frame[2];
+
+        if (frame[0] == RESPONSE && msg_id != 0) {
+            Pending& p = state.pending[msg_id & 255];
+            if (p.active && p.msg_id == msg_id) {
+                p.active = false;
+                if (measuring) (p.isPing ? ping : ack).samples.push_back((uint32_t)(now - p.sentAt));
+            }
+        } else if (frame[0] == HARDWARE && length > 10 && memcmp(frame + 5, "cw\0" "0\0", 5) == 0) {
+            uint32_t seq;
+            if (frame[10] == TINKERIOT_TAG_INT32 && length >= 15) {
+                seq = ((uint32_t)frame[11] << 24) | ((uint32_t)frame[12] << 16) | ((uint32_t)frame[13] << 8) | frame[14];
+            } else {
+                seq = (uint32_t)strtoul((const char*)frame + 10, nullptr, 10);
+            }
+            Outstanding& o = state.echoes[seq & 1023];
+            if (o.active && o.seq == seq) {
+                o.active = false;
+                state.inFlight--;
+                if (measuring) {
+                    echo.samples.push_back((uint32_t)(now - o.sentAt));
+                    roundTrips++;
+                }
+            }
+        }
+    });
+
+    auto track = [&](int client, uint16_t msg_id, bool isPing, uint64_t now) {
+        Pending& p = states[client].pending[msg_id & 255];
+        p.msg_id = msg_id;
+        p.sentAt = now;
+        p.isPing = isPing;
+        p.active = true;
+    };
+
+    // Wait for every client to log in and get past its post-login grace period
+    uint64_t deadline = nowMicros() + 15000000ULL;
+    while (server.loggedInCount() < children.size() && nowMicros() < deadline) server.poll(10);
+    if (server.loggedInCount() < children.size()) {
+        fprintf(stderr, "only %zu of %zu clients logged in\n", server.loggedInCount(), children.size());
+    }
+    uint64_t settle = nowMicros() + 1200000ULL;
+    while (nowMicros() < settle) server.poll(10);
+
+    std::vector<int> clients = server.loggedInClients();
+    uint64_t period = options.rate > 0 ? (uint64_t)(1e6 / options.rate) : 0;
+    uint64_t start = nowMicros();
+    uint64_t measureFrom = start + (uint64_t)(options.warmup * 1e6);
+    uint64_t end = measureFrom + (uint64_t)(options.duration * 1e6);
+    for (size_t i = 0; i < clients.size(); i++) {
+        // Spread open-loop senders evenly over one period
+        states[clients[i]].nextSend = start + (period * i) / clients.size();
+        states[clients[i]].nextPing = start;
+    }
+
+    char body[32];
+    for (;;) {
+        uint64_t now = nowMicros();
+        if (now >= end) break;
+        if (!measuring && now >= measureFrom) measuring = true;
+
+        for (size_t i = 0; i < clients.size(); i++) {
+            int client = clients[i];
+            ClientState& state = states[client];
+
+            // Closed loop waits for the echo, but not forever if one is lost
+            bool due = period ? now >= state.nextSend : state.inFlight == 0 || now - state.lastSend > 1000000ULL;
+            if (due) {
+                state.seq++;
+                int length;
+                if (server.features(client) & TINKERIOT_FEATURE_BINARY_VALUES) {
+                    const uint8_t tagged[10] = { 'c', 'w', 0, '0', 0, TINKERIOT_TAG_INT32, (uint8_t)(state.seq >> 24),
+                                                 (uint8_t)(state.seq >> 16), (uint8_t)(state.seq >> 8), (uint8_t)state.seq };
+                    memcpy(body, tagged, sizeof(tagged));
+                    length = sizeof(tagged);
+                } else {
+                    length = snprintf(body, sizeof(body), "cw%c0%c%u", 0, 0, state.seq);
+                }
+                uint16_t msg_id = server.nextMsgId(client);
+                track(client, msg_id, false, now);
+                Outstanding& o = state.echoes[state.seq & 1023];
+                if (o.active) state.inFlight--;  // Overwritten: counted as lost
+                o.seq = state.seq;
+                o.sentAt = now;
+                o.active = true;
+                state.inFlight++;
+                state.lastSend = now;
+                server.send(client, HARDWARE, msg_id, (const uint8_t*)body, (size_t)length);
+                if (measuring) {
+                    framesOut++;
+                    bytesOut += 5 + length;
+                }
+                if (period) state.nextSend += period;
+            }
+            if (options.pingMs && now >= state.nextPing) {
+                uint16_t msg_id = server.nextMsgId(client);
+                track(client, msg_id, true, now);
+                server.send(client, PING, msg_id, nullptr, 0);
+                if (measuring) {
+                    framesOut++;
+                    bytesOut += 5;
+                }
+                state.nextPing += options.pingMs * 1000ULL;
+            }
+        }
+        server.poll(period ? 1 : 5);
+    }
+    double seconds = (nowMicros() - measureFrom) / 1e6;
+
+    for (size_t i = 0; i < children.size(); i++) kill(children[i], SIGTERM);
+    for (size_t i = 0; i < children.size(); i++) waitpid(children[i], nullptr, 0);
+
+    std::sort(echo.samples.begin(), echo.samples.end());
+    std::sort(ack.samples.begin(), ack.samples.end());
+    std::sort(ping.samples.begin(), ping.samples.end());
+
+    if (options.json) {
+        printf("{\n  \"clients\": %zu, \"seconds\": %.2f, \"rate\": %.1f, \"handler_us\": %u, \"net_task\": %s, "
+               "\"binary\": %s,\n",
+               clients.size(), seconds, options.rate, options.handlerUs, options.netTask ? "true" : "false",
+               options.binary ? "true" : "false");
+        printf("  \"round_trips_per_s\": %.1f, \"frames_per_s\": %.1f, \"bytes_per_s\": %.1f,\n", roundTrips / seconds,
+               (framesIn + framesOut) / seconds, (bytesIn + bytesOut) / seconds);
+        printf("  \"latency\": {\n");
+        printSeries(echo, true, false);
+        printSeries(ack, true, false);
+        printSeries(ping, true, true);
+        printf("  }\n}\n");
+    } else {
+        printf("clients %zu, %.1f s, %s, handler %u us%s%s\n", clients.size(), seconds,
+               period ? "open loop" : "closed loop", options.handlerUs, options.netTask ? ", network task" : "",
+               options.binary ? ", binary values" : "");
+        printf("round trips/s %.0f, frames/s %.0f (in %llu, out %llu), bytes/s %.0f\n", roundTrips / seconds,
+               (framesIn + framesOut) / seconds, (unsigned long long)framesIn, (unsigned long long)framesOut,
+               (bytesIn + bytesOut) / seconds);
+        printf("%-6s %10s %10s %10s %10s %10s %10s\n", "us", "count", "p50", "p90", "p99", "p99.9", "max");
+        printSeries(echo, false, false);
+        printSeries(ack, false, false);
+        if (options.pingMs) printSeries(ping, false, true);
+    }
+    return clients.size() == (size_t)options.clients && !echo.samples.empty() ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// tinkeriot_server: stand-in TinkerIoT server for local testing.
+//
+//   build/tinkeriot_server [--port=8008] [--token=<token>] [--quota=0] [--quiet]
+//
+// Point a board or a host client at ws://<this machine>:<port> with
+// use_ssl off. LOGIN and PING are answered, and so are device frames with
+// a message id; --quota=N refuses device frames past N per second with
+// QUOTA_LIMIT. Every frame is logged. Lines
+// typed on stdin go to all logged-in devices:
+//
+//   cw <pin> <value>     push a value (runs TINKERIOT_WRITE on the device)
+//   cr <pin>             read a pin back
+//   ping
+#include "StandInServer.h"
+
+#include <TinkerIoT.h>
+
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int) {
+    stopping = 1;
+}
+
+static void broadcast(StandInServer& server, uint8_t command, const std::string& body) {
+    std::vector<int> clients = server.loggedInClients();
+    for (size_t i = 0; i < clients.size(); i++) {
+        server.send(clients[i], command, server.nextMsgId(clients[i]), (const uint8_t*)body.data(), body.size());
+    }
+    if (clients.empty()) printf("no devices logged in\n");
+}
+
+static void handleCommand(StandInServer& server, char* line) {
+    char* cmd = strtok(line, " \t\r\n");
+    if (!cmd) return;
+    char* pin = strtok(nullptr, " \t\r\n");
+    char* value = strtok(nullptr, "\r\n");
+
+    if (strcmp(cmd, "cw") == 0 && pin && value) {
+        broadcast(server, HARDWARE, std::string("cw", 3) + pin + '\0' + value);
+    } else if (strcmp(cmd, "cr") == 0 && pin) {
+        broadcast(server, HARDWARE, std::string("cr", 3) + pin);
+    } else if (strcmp(cmd, "ping") == 0) {
+        broadcast(server, PING, std::string());
+    } else {
+        printf("commands: cw <pin> <value> | cr <pin> | ping\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    unsigned port = 8008;
+    const char* token = nullptr;
+    unsigned quota = 0;
+    bool quiet = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--port=", 7) == 0) {
+            port = (unsigned)atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--token=", 8) == 0) {
+            token = argv[i] + 8;
+        } else if (strncmp(argv[i], "--quota=", 8) == 0) {
+            quota = (unsigned)atoi(argv[i] + 8);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else {
+            fprintf(stderr, "usage: %s [--port=8008] [--token=<token>] [--quota=0] [--quiet]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    StandInServer server;
+    server.setToken(token);
+    server.setQuota(quota);
+    server.setVerbose(!quiet);
+    server.onLogin([&server](int client) {
+        printf("[%d] logged in, token '%s'\n", client, server.token(client).c_str());
+    });
+    if (!server.listen((uint16_t)port, "0.0.0.0")) {
+        perror("listen");
+        return 1;
+    }
+    printf("listening on ws://0.0.0.0:%u/hardware/<token>\n", server.port());
+    fflush(stdout);
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    char line[256];
+    bool interactive = true;
+    while (!stopping) {
+        server.poll(50);
+        struct pollfd in = { STDIN_FILENO, POLLIN, 0 };
+        if (interactive && ::poll(&in, 1, 0) > 0) {
+            if (fgets(line, sizeof(line), stdin)) {
+                handleCommand(server, line);
+            } else {
+                interactive = false;  // stdin closed; keep serving
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+
+// ===== STRING =====
+
+bool String::reserveInternal(unsigned int size) {
+    if (_buf && _cap >= size) return true;
+    char* grown = (char*)realloc(_buf, size + 1);
+    if (!grown) return false;
+    if (!_buf) grown[0] = '\0';
+    _buf = grown;
+    _cap = size;
+    return true;
+}
+
+String& String::copy(const char* cstr, unsigned int length) {
+    if (!reserveInternal(length)) return *this;
+    _len = length;
+    memmove(_buf, cstr, length);
+    _buf[length] = '\0';
+    return *this;
+}
+
+String::String(const char* cstr) : _buf(nullptr), _len(0), _cap(0) {
+    if (cstr) copy(cstr, (unsigned int)strlen(cstr));
+}
+
+String::String(const String& other) : _buf(nullptr), _len(0), _cap(0) {
+    copy(other.c_str(), other._len);
+}
+
+String::String(String&& other) noexcept : _buf(other._buf), _len(other._len), _cap(other._cap) {
+    other._buf = nullptr;
+    other._len = other._cap = 0;
+}
+
+String::String(char c) : _buf(nullptr), _len(0), _cap(0) {
+    copy(&c, 1);
+}
+
+static void formatInteger(char* out, unsigned long value, bool negative, unsigned char base) {
+    char tmp[sizeof(unsigned long) * 8 + 2];
+    int n = 0;
+    do {
+        unsigned d = (unsigned)(value % base);
+        tmp[n++] = (char)(d < 10 ? '0' + d : 'a' + d - 10);
+        value /= base;
+    } while (value);
+    if (negative) tmp[n++] = '-';
+    for (int i = 0; i < n; i++) out[i] = tmp[n - 1 - i];
+    out[n] = '\0';
+}
+
+String::String(int value, unsigned char base) : String((long)value, base) {}
+
+String::String(unsigned int value, unsigned char base) : String((unsigned long)value, base) {}
+
+String::String(long value, unsigned char base) : _buf(nullptr), _len(0), _cap(0) {
+    char out[sizeof(long) * 8 + 2];
+    bool negative = value < 0 && base == 10;
+    formatInteger(out, negative ? 0UL - (unsigned long)value : (unsigned long)value, negative, base);
+    copy(out, (unsigned int)strlen(out));
+}
+
+String::String(unsigned long value, unsigned char base) : _buf(nullptr), _len(0), _cap(0) {
+    char out[sizeof(long) * 8 + 2];
+    formatInteger(out, value, false, base);
+    copy(out, (unsigned int)strlen(out));
+}
+
+String::String(float value, unsigned char decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned char decimals) : _buf(nullptr), _len(0), _cap(0) {
+    char out[33];
+    dtostrf(value, decimals + 2, decimals, out);
+    copy(out, (unsigned int)strlen(out));
+}
+
+String::~String() {
+    free(_buf);
+}
+
+String& String::operator=(const String& rhs) {
+    if (this != &rhs) copy(rhs.c_str(), rhs._len);
+    return *this;
+}
+
+String& String::operator=(String&& rhs) noexcept {
+    if (this != &rhs) {
+        free(_buf);
+        _buf = rhs._buf;
+        _len = rhs._len;
+        _cap = rhs._cap;
+        rhs._buf = nullptr;
+        rhs._len = rhs._cap = 0;
+    }
+    return *this;
+}
+
+String& String::operator=(const char* cstr) {
+    if (cstr) copy(cstr, (unsigned int)strlen(cstr));
+    else _len = 0;
+    return *this;
+}
+
+bool String::concat(const char* cstr, unsigned int length) {
+    if (!cstr) return false;
+    if (!reserveInternal(_len + length)) return false;
+    memmove(_buf + _len, cstr, length);
+    _len += length;
+    _buf[_len] = '\0';
+    return true;
+}
+
+char& String::operator[](unsigned int index) {
+    static char dummy;
+    if (index >= _len) {
+        dummy = 0;
+        return dummy;
+    }
+    return _buf[index];
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    for (unsigned int i = from; i < _len; i++) {
+        if (_buf[i] == c) return (int)i;
+    }
+    return -1;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) {
+        unsigned int t = from;
+        from = to;
+        to = t;
+    }
+    if (from >= _len) return String();
+    if (to > _len) to = _len;
+    String out;
+    out.copy(_buf + from, to - from);
+    return out;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    if (_len != s._len) return false;
+    for (unsigned int i = 0; i < _len; i++) {
+        char a = _buf[i], b = s._buf[i];
+        if (a >= 'A' && a <= 'Z') a += 'a' - 'A';
+        if (b >= 'A' && b <= 'Z') b += 'a' - 'A';
+        if (a != b) return false;
+    }
+    return true;
+}
+
+String operator+(const String& lhs, const String& rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, const char* rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const char* lhs, const String& rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+String operator+(const String& lhs, char rhs) {
+    String out(lhs);
+    out.concat(rhs);
+    return out;
+}
+
+char* dtostrf(double value, signed char width, unsigned char prec, char* out) {
+    sprintf(out, "%*.*f", width, prec, value);
+    return out;
+}
+
+// ===== PRINT =====
+
+size_t Print::print(long v, int base) {
+    char out[sizeof(long) * 8 + 2];
+    bool negative = v < 0 && base == 10;
+    formatInteger(out, negative ? 0UL - (unsigned long)v : (unsigned long)v, negative, (unsigned char)base);
+    return print(out);
+}
+
+size_t Print::print(unsigned long v, int base) {
+    char out[sizeof(long) * 8 + 2];
+    formatInteger(out, v, false, (unsigned char)base);
+    return print(out);
+}
+
+size_t Print::print(double v, int digits) {
+    char out[64];
+    snprintf(out, sizeof(out), "%.*f", digits, v);
+    return print(out);
+}
+
+size_t Print::print(const IPAddress& ip) {
+    char out[16];
+    snprintf(out, sizeof(out), "%u.%u.%u.%u", ip.octets[0], ip.octets[1], ip.octets[2], ip.octets[3]);
+    return print(out);
+}
+
+static bool serialEnabled = false;
+
+void TinkerIoTHost::setSerialEnabled(bool enabled) {
+    serialEnabled = enabled;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {
+    if (serialEnabled) fwrite(data, 1, length, stdout);
+    return length;
+}
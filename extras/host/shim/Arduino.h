@@ -0,0 +1,154 @@
+// Host stand-in for the Arduino core.
+// Provides just enough of Arduino.h (String, Print/Serial, millis/micros,
+// delay/yield, interrupt guards) to compile the TinkerIoT sources on Linux.
+#ifndef TINKERIOT_HOST_ARDUINO_H
+#define TINKERIOT_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "TinkerIoTHost.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+
+#define DEC 10
+#define HEX 16
+
+// ===== TIME =====
+inline unsigned long millis() { return (unsigned long)(TinkerIoTHost::nowMicros() / 1000ULL); }
+inline unsigned long micros() { return (unsigned long)TinkerIoTHost::nowMicros(); }
+inline void delay(unsigned long ms) { TinkerIoTHost::sleepMicros((uint64_t)ms * 1000ULL); }
+inline void delayMicroseconds(unsigned int us) { TinkerIoTHost::sleepMicros(us); }
+inline void yield() { TinkerIoTHost::yieldHook(); }
+
+// Interrupts do not exist on the host; the library's host mutex covers
+// thread safety instead.
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline int analogRead(uint8_t) { return 0; }
+
+char* dtostrf(double value, signed char width, unsigned char prec, char* out);
+
+// ===== STRING =====
+// Heap-backed like the real Arduino String (malloc/realloc), so allocation
+// counts measured on the host reflect the device behaviour.
+class String {
+private:
+    char* _buf;
+    unsigned int _len;
+    unsigned int _cap;
+
+    bool reserveInternal(unsigned int size);
+    String& copy(const char* cstr, unsigned int length);
+
+public:
+    String(const char* cstr = "");
+    String(const String& other);
+    String(String&& other) noexcept;
+    explicit String(char c);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+    ~String();
+
+    String& operator=(const String& rhs);
+    String& operator=(String&& rhs) noexcept;
+    String& operator=(const char* cstr);
+
+    bool reserve(unsigned int size) { return reserveInternal(size); }
+    bool concat(const char* cstr, unsigned int length);
+    bool concat(const String& s) { return concat(s._buf, s._len); }
+    bool concat(const char* cstr) { return cstr ? concat(cstr, (unsigned int)strlen(cstr)) : false; }
+    bool concat(char c) { return concat(&c, 1); }
+
+    String& operator+=(const String& rhs) { concat(rhs); return *this; }
+    String& operator+=(const char* cstr) { concat(cstr); return *this; }
+    String& operator+=(char c) { concat(c); return *this; }
+    String& operator+=(int v) { concat(String(v)); return *this; }
+
+    unsigned int length() const { return _len; }
+    const char* c_str() const { return _buf ? _buf : ""; }
+    char operator[](unsigned int index) const { return index < _len ? _buf[index] : 0; }
+    char& operator[](unsigned int index);
+    char charAt(unsigned int index) const { return (*this)[index]; }
+
+    int indexOf(char c, unsigned int from = 0) const;
+    String substring(unsigned int from) const { return substring(from, _len); }
+    String substring(unsigned int from, unsigned int to) const;
+
+    long toInt() const { return atol(c_str()); }
+    float toFloat() const { return (float)atof(c_str()); }
+    double toDouble() const { return atof(c_str()); }
+
+    bool equals(const String& s) const { return _len == s._len && memcmp(c_str(), s.c_str(), _len) == 0; }
+    bool equals(const char* cstr) const { return strcmp(c_str(), cstr ? cstr : "") == 0; }
+    bool equalsIgnoreCase(const String& s) const;
+    bool operator==(const String& rhs) const { return equals(rhs); }
+    bool operator==(const char* cstr) const { return equals(cstr); }
+    bool operator!=(const String& rhs) const { return !equals(rhs); }
+    bool operator!=(const char* cstr) const { return !equals(cstr); }
+};
+
+String operator+(const String& lhs, const String& rhs);
+String operator+(const String& lhs, const char* rhs);
+String operator+(const char* lhs, const String& rhs);
+String operator+(const String& lhs, char rhs);
+
+// ===== PRINT / SERIAL =====
+class IPAddress {
+public:
+    uint8_t octets[4];
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) { octets[0] = a; octets[1] = b; octets[2] = c; octets[3] = d; }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* data, size_t length) = 0;
+    virtual int availableForWrite() { return 0; }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const String& s) { return write((const uint8_t*)s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC);
+    size_t print(unsigned long v, int base = DEC);
+    size_t print(double v, int digits = 2);
+    size_t print(const IPAddress& ip);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int format) { size_t n = print(v, format); return n + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    operator bool() const { return true; }
+    size_t write(const uint8_t* data, size_t length) override;
+    int availableForWrite() override { return 4096; }  // stdout never makes run() wait
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // TINKERIOT_HOST_ARDUINO_H
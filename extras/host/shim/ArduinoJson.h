@@ -0,0 +1,4 @@
+// Host stand-in for ArduinoJson. TinkerIoT.h includes it but does not use it.
+#ifndef TINKERIOT_HOST_ARDUINOJSON_H
+#define TINKERIOT_HOST_ARDUINOJSON_H
+#endif
@@ -0,0 +1,202 @@
+#include "HostWebSocket.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <time.h>
+
+namespace HostWebSocket {
+
+// ===== SHA-1 / BASE64 (handshake only) =====
+
+static uint32_t rol(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void sha1(const uint8_t* data, size_t length, uint8_t digest[20]) {
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    std::vector<uint8_t> msg(data, data + length);
+    msg.push_back(0x80);
+    while (msg.size() % 64 != 56) msg.push_back(0);
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 7; i >= 0; i--) msg.push_back((uint8_t)(bits >> (i * 8)));
+
+    for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const uint8_t* p = &msg[chunk + i * 4];
+            w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = h[i] >> 24;
+        digest[i * 4 + 1] = h[i] >> 16;
+        digest[i * 4 + 2] = h[i] >> 8;
+        digest[i * 4 + 3] = h[i];
+    }
+}
+
+static std::string base64(const uint8_t* data, size_t length) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < length) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < length) v |= data[i + 2];
+        out += table[(v >> 18) & 63];
+        out += table[(v >> 12) & 63];
+        out += i + 1 < length ? table[(v >> 6) & 63] : '=';
+        out += i + 2 < length ? table[v & 63] : '=';
+    }
+    return out;
+}
+
+std::string makeClientKey() {
+    static bool seeded = false;
+    if (!seeded) {
+        srand((unsigned)time(nullptr) ^ (unsigned)(uintptr_t)&seeded);
+        seeded = true;
+    }
+    uint8_t raw[16];
+    for (int i = 0; i < 16; i++) raw[i] = (uint8_t)rand();
+    return base64(raw, sizeof(raw));
+}
+
+std::string acceptKey(const std::string& clientKey) {
+    std::string input = clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    uint8_t digest[20];
+    sha1((const uint8_t*)input.data(), input.size(), digest);
+    return base64(digest, sizeof(digest));
+}
+
+// ===== FRAMES =====
+
+void encodeFrame(std::vector<uint8_t>& out, uint8_t opcode, const uint8_t* payload, size_t length, bool mask) {
+    out.push_back(0x80 | opcode);
+    uint8_t maskBit = mask ? 0x80 : 0;
+    if (length < 126) {
+        out.push_back(maskBit | (uint8_t)length);
+    } else if (length <= 0xFFFF) {
+        out.push_back(maskBit | 126);
+        out.push_back((uint8_t)(length >> 8));
+        out.push_back((uint8_t)length);
+    } else {
+        out.push_back(maskBit | 127);
+        for (int i = 7; i >= 0; i--) out.push_back((uint8_t)((uint64_t)length >> (i * 8)));
+    }
+
+    uint8_t key[4] = { 0, 0, 0, 0 };
+    if (mask) {
+        for (int i = 0; i < 4; i++) key[i] = (uint8_t)rand();
+        out.insert(out.end(), key, key + 4);
+    }
+    size_t start = out.size();
+    out.insert(out.end(), payload, payload + length);
+    if (mask) {
+        for (size_t i = 0; i < length; i++) out[start + i] ^= key[i & 3];
+    }
+}
+
+long decodeFrame(const uint8_t* data, size_t length, Frame& frame) {
+    if (length < 2) return 0;
+    size_t pos = 2;
+    uint64_t payloadLength = data[1] & 0x7F;
+    bool masked = (data[1] & 0x80) != 0;
+    if ((data[0] & 0x70) != 0) return -1;  // No extensions negotiated
+
+    if (payloadLength == 126) {
+        if (length < pos + 2) return 0;
+        payloadLength = ((uint64_t)data[2] << 8) | data[3];
+        pos += 2;
+    } else if (payloadLength == 127) {
+        if (length < pos + 8) return 0;
+        payloadLength = 0;
+        for (int i = 0; i < 8; i++) payloadLength = (payloadLength << 8) | data[2 + i];
+        pos += 8;
+    }
+    if (payloadLength > (1u << 24)) return -1;
+
+    uint8_t key[4] = { 0, 0, 0, 0 };
+    if (masked) {
+        if (length < pos + 4) return 0;
+        memcpy(key, data + pos, 4);
+        pos += 4;
+    }
+    if (length < pos + payloadLength) return 0;
+
+    frame.fin = (data[0] & 0x80) != 0;
+    frame.opcode = data[0] & 0x0F;
+    frame.length = (size_t)payloadLength;
+    frame.payload.assign(data + pos, data + pos + payloadLength);
+    if (masked) {
+        for (size_t i = 0; i < payloadLength; i++) frame.payload[i] ^= key[i & 3];
+    }
+    frame.payload.push_back(0);  // NUL-terminated, as arduinoWebSockets delivers it
+    return (long)(pos + payloadLength);
+}
+
+std::string headerValue(const std::string& head, const char* name) {
+    size_t nameLength = strlen(name);
+    size_t lineStart = head.find("\r\n");  // Skip the request/status line
+    while (lineStart != std::string::npos) {
+        lineStart += 2;
+        size_t lineEnd = head.find("\r\n", lineStart);
+        if (lineEnd == std::string::npos) lineEnd = head.size();
+        if (lineEnd - lineStart > nameLength && head[lineStart + nameLength] == ':' &&
+            strncasecmp(head.c_str() + lineStart, name, nameLength) == 0) {
+            size_t valueStart = lineStart + nameLength + 1;
+            while (valueStart < lineEnd && head[valueStart] == ' ') valueStart++;
+            return head.substr(valueStart, lineEnd - valueStart);
+        }
+        lineStart = lineEnd < head.size() ? lineEnd : std::string::npos;
+    }
+    return std::string();
+}
+
+bool sendAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return true;
+}
+
+} // namespace HostWebSocket
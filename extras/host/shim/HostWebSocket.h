@@ -0,0 +1,51 @@
+// RFC 6455 wire helpers shared by the host WebSocket client stand-in and
+// the stand-in server: handshake keys and frame encode/decode. Only what
+// the TinkerIoT protocol needs - no extensions, no fragmentation on send.
+#ifndef TINKERIOT_HOST_WEBSOCKET_H
+#define TINKERIOT_HOST_WEBSOCKET_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace HostWebSocket {
+
+enum Opcode {
+    OP_CONTINUATION = 0x0,
+    OP_TEXT = 0x1,
+    OP_BINARY = 0x2,
+    OP_CLOSE = 0x8,
+    OP_PING = 0x9,
+    OP_PONG = 0xA
+};
+
+struct Frame {
+    uint8_t opcode;
+    bool fin;
+    size_t length;
+    std::vector<uint8_t> payload;   // Unmasked, plus a trailing NUL at [length]
+};
+
+// Random 16-byte key, base64 encoded (client side of the handshake)
+std::string makeClientKey();
+
+// base64(SHA-1(key + RFC 6455 GUID)) (server side of the handshake)
+std::string acceptKey(const std::string& clientKey);
+
+// Append one frame to 'out'. Clients must mask, servers must not.
+void encodeFrame(std::vector<uint8_t>& out, uint8_t opcode, const uint8_t* payload, size_t length, bool mask);
+
+// Decode one frame from the front of 'data'. Returns the number of bytes
+// consumed, 0 if more data is needed, or -1 on a protocol error.
+long decodeFrame(const uint8_t* data, size_t length, Frame& frame);
+
+// Value of an HTTP header in a request/response head (case-insensitive name)
+std::string headerValue(const std::string& head, const char* name);
+
+// send() the whole buffer on a blocking socket; false on error
+bool sendAll(int fd, const uint8_t* data, size_t length);
+
+} // namespace HostWebSocket
+
+#endif // TINKERIOT_HOST_WEBSOCKET_H
@@ -0,0 +1,457 @@
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WebSocketsClient.h>
+
+#include "HostWebSocket.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+WiFiClass WiFi;
+
+// ===== CLOCK =====
+
+static std::atomic<bool> virtualClockEnabled(false);
+static std::atomic<uint64_t> virtualNow(0);
+static TinkerIoTHost::YieldHook currentYieldHook = nullptr;
+
+static uint64_t monotonicMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+void TinkerIoTHost::useVirtualClock(bool enabled) {
+    virtualClockEnabled = enabled;
+}
+
+bool TinkerIoTHost::virtualClock() {
+    return virtualClockEnabled;
+}
+
+uint64_t TinkerIoTHost::nowMicros() {
+    if (virtualClockEnabled) return virtualNow.load(std::memory_order_relaxed);
+    static const uint64_t start = monotonicMicros();
+    return monotonicMicros() - start;
+}
+
+void TinkerIoTHost::setMicros(uint64_t now) {
+    virtualNow = now;
+}
+
+void TinkerIoTHost::advanceMicros(uint64_t delta) {
+    virtualNow.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void TinkerIoTHost::sleepMicros(uint64_t us) {
+    if (virtualClockEnabled) {
+        advanceMicros(us);
+        return;
+    }
+    struct timespec ts;
+    ts.tv_sec = (time_t)(us / 1000000ULL);
+    ts.tv_nsec = (long)(us % 1000000ULL) * 1000L;
+    nanosleep(&ts, nullptr);
+}
+
+void TinkerIoTHost::setYieldHook(YieldHook hook) {
+    currentYieldHook = hook;
+}
+
+void TinkerIoTHost::yieldHook() {
+    if (currentYieldHook) currentYieldHook();
+}
+
+// ===== WIFI =====
+
+static unsigned long wifiConnectDelay = 0;
+static bool wifiLost = false;
+
+void TinkerIoTHost::setWiFiConnectDelay(unsigned long ms) {
+    wifiConnectDelay = ms;
+}
+
+void TinkerIoTHost::wifiDrop() {
+    wifiLost = true;
+}
+
+int WiFiClass::begin(const char*, const char*) {
+    _begun = true;
+    _beginTime = millis();
+    wifiLost = false;
+    return status();
+}
+
+wl_status_t WiFiClass::status() {
+    if (!_begun) return WL_IDLE_STATUS;
+    if (wifiLost) return WL_CONNECTION_LOST;
+    return (millis() - _beginTime >= wifiConnectDelay) ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+// ===== WEBSOCKET LINK =====
+
+namespace {
+
+struct Link {
+    std::mutex lock;
+    std::deque<std::vector<uint8_t> > inbound;
+    TinkerIoTHost::FrameSink sink = nullptr;
+    void* sinkCtx = nullptr;
+    bool autoConnect = true;
+    bool connectPending = false;
+    bool disconnectPending = false;
+    bool tcp = false;
+    WebSocketsClient* client = nullptr;
+    int wakePipe[2] = { -1, -1 };       // linkWake() / linkDeliver() -> linkWait()
+
+    Link() {
+        if (pipe(wakePipe) == 0) {
+            fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+            fcntl(wakePipe[1], F_SETFL, O_NONBLOCK);
+        }
+    }
+};
+
+Link& link() {
+    static Link instance;
+    return instance;
+}
+
+} // namespace
+
+void TinkerIoTHost::linkSetSink(FrameSink sink, void* ctx) {
+    std::lock_guard<std::mutex> guard(link().lock);
+    link().sink = sink;
+    link().sinkCtx = ctx;
+}
+
+void TinkerIoTHost::linkSetAutoConnect(bool enabled) {
+    link().autoConnect = enabled;
+}
+
+void TinkerIoTHost::linkConnect() {
+    std::lock_guard<std::mutex> guard(link().lock);
+    link().connectPending = true;
+    link().disconnectPending = false;
+}
+
+void TinkerIoTHost::linkDisconnect() {
+    std::lock_guard<std::mutex> guard(link().lock);
+    link().disconnectPending = true;
+    link().connectPending = false;
+    link().inbound.clear();
+}
+
+void TinkerIoTHost::linkDeliver(const uint8_t* frame, size_t length) {
+    std::vector<uint8_t> copy(frame, frame + length);
+    copy.push_back(0);  // arduinoWebSockets NUL-terminates every payload
+    {
+        std::lock_guard<std::mutex> guard(link().lock);
+        link().inbound.push_back(std::move(copy));
+    }
+    TinkerIoTHost::linkWake();
+}
+
+size_t TinkerIoTHost::linkPending() {
+    std::lock_guard<std::mutex> guard(link().lock);
+    return link().inbound.size();
+}
+
+void TinkerIoTHost::linkDispatch(uint8_t* frame, size_t length) {
+    if (link().client) link().client->hostEvent(WStype_BIN, frame, length);
+}
+
+void TinkerIoTHost::useTcpTransport(bool enabled) {
+    link().tcp = enabled;
+}
+
+bool TinkerIoTHost::linkWait(unsigned long timeoutMs) {
+    Link& l = link();
+    WebSocketsClient* client = l.client;
+    if (client && client->hostBuffered()) return true;
+    {
+        std::lock_guard<std::mutex> guard(l.lock);
+        if (!l.inbound.empty() || l.connectPending || l.disconnectPending) return true;
+    }
+    if (virtualClockEnabled) {
+        if (timeoutMs != (unsigned long)-1) advanceMillis(timeoutMs);
+        return false;
+    }
+
+    struct pollfd fds[2];
+    int count = 0;
+    fds[count].fd = l.wakePipe[0];
+    fds[count].events = POLLIN;
+    fds[count++].revents = 0;
+    if (client && client->hostFd() >= 0) {
+        fds[count].fd = client->hostFd();
+        fds[count].events = POLLIN;
+        fds[count++].revents = 0;
+    }
+    int timeout = timeoutMs > (unsigned long)INT_MAX ? -1 : (int)timeoutMs;
+    int ready = poll(fds, count, timeout);
+    if (ready > 0 && fds[0].revents) {
+        char drain[64];
+        while (read(l.wakePipe[0], drain, sizeof(drain)) > 0) {
+        }
+    }
+    return ready > 0;
+}
+
+void TinkerIoTHost::linkWake() {
+    char byte = 1;
+    ssize_t ignored = write(link().wakePipe[1], &byte, 1);  // Full pipe: already awake
+    (void)ignored;
+}
+
+WebSocketsClient::WebSocketsClient() {
+    _url[0] = '\0';
+}
+
+WebSocketsClient::~WebSocketsClient() {
+    if (link().client == this) link().client = nullptr;
+}
+
+void WebSocketsClient::begin(const char* host, uint16_t port, const char* url, const char* protocol) {
+    strncpy(_url, url, sizeof(_url) - 1);
+    _url[sizeof(_url) - 1] = '\0';
+    std::lock_guard<std::mutex> guard(link().lock);
+    link().client = this;
+    _tcp = link().tcp;
+    if (_tcp) {
+        _host = host;
+        _port = port;
+        _protocol = protocol ? protocol : "";
+        _begun = true;
+        _attempted = false;
+    } else if (link().autoConnect) {
+        link().connectPending = true;
+    }
+}
+
+void WebSocketsClient::beginSSL(const char* host, uint16_t port, const char* url, const char*, const char* protocol) {
+    begin(host, port, url, protocol);
+}
+
+void WebSocketsClient::disconnect() {
+    if (_tcp) {
+        tcpClose();
+        return;
+    }
+    if (!_connected) return;
+    _connected = false;
+    hostEvent(WStype_DISCONNECTED, nullptr, 0);
+}
+
+void WebSocketsClient::loop() {
+    if (_tcp) {
+        tcpLoop();
+        return;
+    }
+
+    Link& l = link();
+    std::vector<uint8_t> frame;
+    bool connect = false;
+    bool disconnect = false;
+    {
+        std::lock_guard<std::mutex> guard(l.lock);
+        if (l.disconnectPending) {
+            l.disconnectPending = false;
+            disconnect = _connected;
+        } else if (l.connectPending) {
+            l.connectPending = false;
+            connect = !_connected;
+        } else if (_connected && !l.inbound.empty()) {
+            frame.swap(l.inbound.front());
+            l.inbound.pop_front();
+        }
+    }
+
+    if (disconnect) {
+        _connected = false;
+        hostEvent(WStype_DISCONNECTED, nullptr, 0);
+    } else if (connect) {
+        _connected = true;
+        hostEvent(WStype_CONNECTED, (uint8_t*)_url, strlen(_url));
+    } else if (!frame.empty()) {
+        hostEvent(WStype_BIN, frame.data(), frame.size() - 1);
+    }
+}
+
+bool WebSocketsClient::sendBIN(uint8_t* payload, size_t length, bool) {
+    return sendBIN((const uint8_t*)payload, length);
+}
+
+bool WebSocketsClient::sendBIN(const uint8_t* payload, size_t length) {
+    if (!_connected) return false;
+    if (_tcp) return tcpSend(HostWebSocket::OP_BINARY, payload, length);
+    TinkerIoTHost::FrameSink sink;
+    void* ctx;
+    {
+        std::lock_guard<std::mutex> guard(link().lock);
+        sink = link().sink;
+        ctx = link().sinkCtx;
+    }
+    if (sink) sink(payload, length, ctx);
+    return true;
+}
+
+bool WebSocketsClient::sendTXT(const char* payload) {
+    if (!_connected) return false;
+    if (_tcp) return tcpSend(HostWebSocket::OP_TEXT, (const uint8_t*)payload, strlen(payload));
+    return true;
+}
+
+// ===== WEBSOCKET OVER TCP =====
+// Connect and handshake are blocking (loopback or LAN only); receive is
+// non-blocking and, like arduinoWebSockets, each loop() handles at most one
+// frame.
+
+void WebSocketsClient::tcpConnect() {
+    _attempted = true;
+    _lastAttempt = millis();
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", _port);
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addrs = nullptr;
+    if (getaddrinfo(_host.c_str(), port, &hints, &addrs) != 0) return;
+
+    int fd = -1;
+    for (struct addrinfo* a = addrs; a; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, a->ai_addr, a->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(addrs);
+    if (fd < 0) return;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    _key = HostWebSocket::makeClientKey();
+    std::string request = std::string("GET ") + _url + " HTTP/1.1\r\n"
+                          "Host: " + _host + ":" + port + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + _key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n";
+    if (!_protocol.empty()) request += "Sec-WebSocket-Protocol: " + _protocol + "\r\n";
+    request += "\r\n";
+    if (!HostWebSocket::sendAll(fd, (const uint8_t*)request.data(), request.size())) {
+        close(fd);
+        return;
+    }
+
+    _fd = fd;
+    _state = TCP_HANDSHAKE;
+    _rx.clear();
+}
+
+void WebSocketsClient::tcpClose() {
+    if (_fd >= 0) {
+        close(_fd);
+        _fd = -1;
+    }
+    _state = TCP_CLOSED;
+    _rx.clear();
+    _lastAttempt = millis();
+    if (_connected) {
+        _connected = false;
+        hostEvent(WStype_DISCONNECTED, nullptr, 0);
+    }
+}
+
+bool WebSocketsClient::tcpSend(uint8_t opcode, const uint8_t* payload, size_t length) {
+    if (_fd < 0) return false;
+    _tx.clear();
+    HostWebSocket::encodeFrame(_tx, opcode, payload, length, true);
+    if (!HostWebSocket::sendAll(_fd, _tx.data(), _tx.size())) {
+        tcpClose();
+        return false;
+    }
+    return true;
+}
+
+void WebSocketsClient::tcpLoop() {
+    if (_fd < 0) {
+        if (_begun && (!_attempted || millis() - _lastAttempt >= _reconnectInterval)) tcpConnect();
+        return;
+    }
+
+    uint8_t chunk[4096];
+    for (;;) {
+        ssize_t n = recv(_fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (n > 0) {
+            _rx.insert(_rx.end(), chunk, chunk + n);
+            if ((size_t)n < sizeof(chunk)) break;
+        } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            tcpClose();
+            return;
+        } else {
+            break;
+        }
+    }
+
+    if (_state == TCP_HANDSHAKE) {
+        std::string head(_rx.begin(), _rx.end());
+        size_t end = head.find("\r\n\r\n");
+        if (end == std::string::npos) return;
+        head.resize(end + 2);
+        if (head.compare(0, 12, "HTTP/1.1 101") != 0 ||
+            HostWebSocket::headerValue(head, "Sec-WebSocket-Accept") != HostWebSocket::acceptKey(_key)) {
+            tcpClose();
+            return;
+        }
+        _rx.erase(_rx.begin(), _rx.begin() + end + 4);
+        _state = TCP_OPEN;
+        _connected = true;
+        hostEvent(WStype_CONNECTED, (uint8_t*)_url, strlen(_url));
+        return;
+    }
+
+    HostWebSocket::Frame frame;
+    long used = HostWebSocket::decodeFrame(_rx.data(), _rx.size(), frame);
+    if (used < 0) {
+        tcpClose();
+        return;
+    }
+    if (used == 0) return;
+    _rx.erase(_rx.begin(), _rx.begin() + used);
+
+    switch (frame.opcode) {
+        case HostWebSocket::OP_BINARY:
+            hostEvent(WStype_BIN, frame.payload.data(), frame.length);
+            break;
+        case HostWebSocket::OP_TEXT:
+            hostEvent(WStype_TEXT, frame.payload.data(), frame.length);
+            break;
+        case HostWebSocket::OP_PING:
+            tcpSend(HostWebSocket::OP_PONG, frame.payload.data(), frame.length);
+            break;
+        case HostWebSocket::OP_CLOSE:
+            tcpSend(HostWebSocket::OP_CLOSE, nullptr, 0);
+            tcpClose();
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,70 @@
+// Control surface for the host stand-ins (clock, Serial, WiFi, WebSocket link).
+// Host programs use this to drive TinkerIoT without a board or a network.
+#ifndef TINKERIOT_HOST_CONTROL_H
+#define TINKERIOT_HOST_CONTROL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace TinkerIoTHost {
+
+// ===== CLOCK =====
+// The virtual clock only moves when told to (or when the library calls
+// delay()), which makes timing behaviour reproducible. The real clock is
+// CLOCK_MONOTONIC.
+void useVirtualClock(bool enabled);
+bool virtualClock();
+uint64_t nowMicros();
+void setMicros(uint64_t now);
+void advanceMicros(uint64_t delta);
+inline void advanceMillis(uint64_t delta) { advanceMicros(delta * 1000ULL); }
+void sleepMicros(uint64_t us);
+
+// Called from yield(); null by default
+typedef void (*YieldHook)();
+void setYieldHook(YieldHook hook);
+void yieldHook();
+
+// ===== SERIAL =====
+// Serial output goes to stdout when enabled (default: disabled)
+void setSerialEnabled(bool enabled);
+
+// ===== WIFI =====
+// WiFi.status() reports WL_CONNECTED this long after WiFi.begin()
+void setWiFiConnectDelay(unsigned long ms);
+// Lose the association: WiFi.status() reports WL_CONNECTION_LOST until the
+// next WiFi.begin(), as on WiFiNINA
+void wifiDrop();
+
+// ===== WEBSOCKET LINK (in-memory pipe) =====
+// Outbound frames (client -> server) are handed to the sink. Inbound frames
+// are queued and delivered one per WebSocketsClient::loop(), as the real
+// client library does.
+typedef void (*FrameSink)(const uint8_t* frame, size_t length, void* ctx);
+void linkSetSink(FrameSink sink, void* ctx);
+void linkSetAutoConnect(bool enabled);      // accept on begin() (default: true)
+void linkConnect();                          // raise WStype_CONNECTED on next loop()
+void linkDisconnect();                       // raise WStype_DISCONNECTED on next loop()
+void linkDeliver(const uint8_t* frame, size_t length);
+size_t linkPending();
+
+// Calls the client's WStype_BIN handler synchronously, bypassing the queue.
+// frame[length] must be readable and zero, matching the real client library.
+void linkDispatch(uint8_t* frame, size_t length);
+
+// ===== WEBSOCKET OVER TCP =====
+// With TCP enabled (before begin()), WebSocketsClient opens a real RFC 6455
+// connection to host:port instead of using the in-memory link - plain ws://,
+// also for beginSSL(). Pair it with the real clock and tinkeriot_server.
+void useTcpTransport(bool enabled);
+
+// Block until the transport has something for loop(), linkWake() is
+// called or the timeout passes (unsigned long max: no timeout). Backs
+// TinkerIoT.waitForEvent(); true if woken before the timeout. On the
+// virtual clock it does not block: it advances the clock instead.
+bool linkWait(unsigned long timeoutMs);
+void linkWake();                             // Any thread
+
+} // namespace TinkerIoTHost
+
+#endif // TINKERIOT_HOST_CONTROL_H
@@ -0,0 +1,87 @@
+// Host stand-in for the arduinoWebSockets client (Links2004).
+// Same public surface as the parts TinkerIoT uses; the transport is the
+// in-memory link from TinkerIoTHost.h, or a real WebSocket over TCP when
+// TinkerIoTHost::useTcpTransport(true) is set.
+#ifndef TINKERIOT_HOST_WEBSOCKETSCLIENT_H
+#define TINKERIOT_HOST_WEBSOCKETSCLIENT_H
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    WebSocketsClient();
+    ~WebSocketsClient();
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino");
+    void beginSSL(const char* host, uint16_t port, const char* url = "/", const char* fingerprint = "", const char* protocol = "arduino");
+    void disconnect();
+
+    void onEvent(WebSocketClientEvent cbEvent) { _cbEvent = cbEvent; }
+    void setReconnectInterval(unsigned long time) { _reconnectInterval = time; }
+
+    void loop();
+
+    bool sendBIN(uint8_t* payload, size_t length, bool headerToPayload = false);
+    bool sendBIN(const uint8_t* payload, size_t length);
+    bool sendTXT(const char* payload);
+
+    bool isConnected() { return _connected; }
+
+    // Host only: raise an event as the transport would
+    void hostEvent(WStype_t type, uint8_t* payload, size_t length) {
+        if (_cbEvent) _cbEvent(type, payload, length);
+    }
+
+    // Host only: TCP socket (-1 on the in-memory link or when closed) and
+    // whether received bytes are still waiting to be processed
+    int hostFd() const { return _fd; }
+    bool hostBuffered() const { return !_rx.empty(); }
+
+private:
+    enum TcpState { TCP_CLOSED, TCP_HANDSHAKE, TCP_OPEN };
+
+    void tcpConnect();
+    void tcpClose();
+    void tcpLoop();
+    bool tcpSend(uint8_t opcode, const uint8_t* payload, size_t length);
+
+    WebSocketClientEvent _cbEvent;
+    unsigned long _reconnectInterval = 500;
+    bool _connected = false;
+    char _url[128];
+
+    // TCP transport
+    bool _tcp = false;
+    bool _begun = false;
+    int _fd = -1;
+    TcpState _state = TCP_CLOSED;
+    std::string _host;
+    uint16_t _port = 0;
+    std::string _protocol;
+    std::string _key;
+    unsigned long _lastAttempt = 0;
+    bool _attempted = false;
+    std::vector<uint8_t> _rx;
+    std::vector<uint8_t> _tx;
+};
+
+#endif // TINKERIOT_HOST_WEBSOCKETSCLIENT_H
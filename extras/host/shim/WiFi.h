@@ -0,0 +1,33 @@
+// Host stand-in for the Arduino WiFi library.
+#ifndef TINKERIOT_HOST_WIFI_H
+#define TINKERIOT_HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_NO_SHIELD = 255,
+    WL_NO_MODULE = 255,
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+private:
+    bool _begun = false;
+    unsigned long _beginTime = 0;
+
+public:
+    int begin(const char* ssid, const char* password);
+    void disconnect() { _begun = false; }
+    wl_status_t status();
+    IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // TINKERIOT_HOST_WIFI_H